@@ -0,0 +1,164 @@
+// batch_run.hpp
+// 오프라인 배치 모드 (--batch): 비디오·이미지 디렉터리를 서버와 같은 스케줄러·워커로 추론해
+// JSONL (파일 안의 프레임 순서대로) 과 검출 로그로 기록한다.
+#pragma once
+#include <sys/stat.h>
+
+#include <atomic>
+#include <cctype>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "infer_sched.hpp"
+#include "det_log.hpp"
+#include "numa_topo.hpp"
+
+/* ───── 오프라인 배치 모드 (--batch) ─────────────────────────────────────
+ * 비디오 파일·이미지 디렉터리를 실시간 제약 없이 최대 처리량으로 추론한다.
+ * 리더 스레드들이 파일을 나눠 디코드하고, 프레임은 서버와 같은 스케줄러·워커
+ * (같은 형태끼리 배치 추론)를 거쳐 JSONL / 검출 로그로 기록된다.            */
+constexpr int BATCH_INFLIGHT = 8;                 // 리더당 결과 대기 중인 프레임 수
+
+struct BatchItem { std::string path, stream; bool video; };
+
+inline bool isImageFile(const std::string& path)
+{
+    auto dot=path.find_last_of('.'); if(dot==std::string::npos) return false;
+    std::string ext=path.substr(dot+1);
+    for(char& ch: ext) ch=(char)std::tolower((unsigned char)ch);
+    return ext=="jpg" || ext=="jpeg" || ext=="png" || ext=="bmp";
+}
+
+inline std::string streamName(std::string path)
+{
+    while(!path.empty() && path.back()=='/') path.pop_back();
+    auto slash=path.find_last_of('/'); if(slash!=std::string::npos) path=path.substr(slash+1);
+    auto dot=path.find_last_of('.');   if(dot!=std::string::npos && dot>0) path=path.substr(0,dot);
+    for(char& ch: path) if(!std::isalnum((unsigned char)ch) && ch!='-' && ch!='_') ch='_';
+    return path;
+}
+
+// 인자 목록 → 처리 항목 (디렉터리는 안의 이미지들, 그 외는 비디오/이미지 파일)
+inline std::vector<BatchItem> expandInputs(const std::vector<std::string>& args)
+{
+    std::vector<BatchItem> items;
+    for(const auto& a: args){
+        struct stat st{};
+        if(stat(a.c_str(),&st)==0 && S_ISDIR(st.st_mode)){
+            std::vector<cv::String> files; cv::glob(a+"/*",files,false);
+            for(const auto& f: files) if(isImageFile(f)) items.push_back({f,streamName(a),false});
+        }else items.push_back({a,streamName(a),!isImageFile(a)});
+    }
+    return items;
+}
+
+inline std::string jsonEscape(const std::string& s)
+{
+    std::string o;
+    for(char ch: s){ if(ch=='"'||ch=='\\') o+='\\'; o+=ch; }
+    return o;
+}
+
+class BatchOut {
+public:
+    BatchOut(const std::string& path, DetLogWriter* detlog) : jsonl_(path), detlog_(detlog) {}
+    bool ok() const { return (bool)jsonl_; }
+
+    void write(const BatchItem& it, uint64_t frame_id, int64_t ts_us, const Result& r){
+        std::ostringstream ss;
+        ss<<"{\"src\":\""<<jsonEscape(it.path)<<"\",\"frame\":"<<frame_id<<",\"ts_us\":"<<ts_us<<",\"dets\":[";
+        for(size_t k=0;k<r.dets.size();++k){
+            const auto& d=r.dets[k];
+            ss<<(k?",":"")<<'['<<d.box.x<<','<<d.box.y<<','<<d.box.width<<','<<d.box.height<<','<<d.cls<<','<<d.score<<']';
+        }
+        ss<<"]}\n";
+        {   std::lock_guard<std::mutex> lk(m_); jsonl_<<ss.str(); }
+        if(detlog_) detlog_->append(it.stream,toRows(frame_id,ts_us,r.dets));
+        frames.fetch_add(1,std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t> frames{0};
+private:
+    std::mutex m_; std::ofstream jsonl_; DetLogWriter* detlog_;
+};
+
+inline void batchReader(Domain& dom, const std::vector<BatchItem>& items, std::atomic<size_t>& next, BatchOut& out)
+{
+    if(dom.pin) pinThread(dom.cpus);
+    const FilterPtr filter=std::make_shared<ClassFilter>();
+    for(size_t idx; (idx=next++)<items.size(); ){
+        const BatchItem& it=items[idx];
+        cv::VideoCapture cap;
+        if(it.video && !cap.open(it.path)){ FLOG_WARN("open failed: {}",it.path); continue; }
+
+        // 결과는 파일 안의 프레임 순서대로 기록 (앞의 것부터 기다림)
+        std::deque<std::tuple<uint64_t,int64_t,std::future<Result>>> inflight;
+        auto drain=[&](size_t keep){
+            while(inflight.size()>keep){
+                auto& f=inflight.front();
+                out.write(it,std::get<0>(f),std::get<1>(f),std::get<2>(f).get());
+                inflight.pop_front();
+            }
+        };
+        for(uint64_t fno=0;;++fno){
+            cv::Mat img; int64_t ts_us=0;
+            if(it.video){
+                if(!cap.read(img)) break;
+                ts_us=(int64_t)(cap.get(cv::CAP_PROP_POS_MSEC)*1000);
+            }else{
+                if(fno>0) break;
+                img=cv::imread(it.path);
+                if(img.empty()){ FLOG_WARN("read failed: {}",it.path); break; }
+            }
+            auto job=std::make_shared<Job>();
+            job->tier=0; job->frame_no=fno; job->imgsz=INPUT_W;       // tier 0: 버리지도 강등하지도 않음
+            job->img=std::move(img); job->filter=filter; job->deadline=Clock::time_point::max();
+            inflight.emplace_back(it.video ? fno : idx, ts_us, job->result.get_future());
+            dom.sched.submit(std::move(job));
+            drain(BATCH_INFLIGHT);
+        }
+        drain(0);
+    }
+}
+
+// 리더는 도메인들에 돌아가며 붙는다. detlog 가 있으면 스트림별 검출 로그도
+inline int runBatch(std::vector<std::unique_ptr<Domain>>& domains, DetLogWriter* detlog,
+                    const std::vector<std::string>& inputs, std::map<std::string,std::string>& opt)
+{
+    auto items=expandInputs(inputs);
+    if(items.empty()){ std::cerr<<"❌ no inputs\n"; return 1; }
+    const std::string out_path = opt.count("out") ? opt["out"] : "results.jsonl";
+    BatchOut out(out_path, detlog);
+    if(!out.ok()){ perror(out_path.c_str()); return 1; }
+
+    const size_t readers = opt.count("readers") ? std::stoul(opt["readers"])
+                         : std::min(items.size(), (size_t)std::max(2u, std::thread::hardware_concurrency()/4));
+    std::cout<<"🔵 BATCH : "<<items.size()<<" inputs, "<<readers<<" readers → "<<out_path<<'\n';
+
+    auto t0=Clock::now();
+    std::atomic<size_t> next{0}; std::atomic<size_t> done{0};
+    std::vector<std::thread> th;
+    for(size_t i=0;i<readers;++i)
+        th.emplace_back([&,i]{ batchReader(*domains[i%domains.size()],items,next,out); ++done; });
+
+    while(done<readers){                                  // 진행 상황 (2초마다)
+        std::this_thread::sleep_for(std::chrono::seconds(2));
+        double sec=std::chrono::duration<double>(Clock::now()-t0).count();
+        std::cout<<"🟡 "<<out.frames<<" frames, "<<out.frames/sec<<" fps\n";
+    }
+    for(auto& t: th) t.join();
+
+    double sec=std::chrono::duration<double>(Clock::now()-t0).count();
+    std::cout<<"🟢 done: "<<out.frames<<" frames in "<<sec<<"s = "<<out.frames/sec<<" fps\n";
+    return 0;
+}
@@ -0,0 +1,228 @@
+// co_loop.hpp
+// C++20 코루틴 + epoll 이벤트 루프. 연결마다 스레드를 두지 않고 코루틴 하나로 처리한다.
+//   co::Task<bool> t = loop.recvAll(fd, buf, n);     // 데이터가 없으면 루프로 양보
+//   auto r = co_await loop.offload(pool, [&]{ ... });  // CPU 작업은 풀에서, 끝나면 루프로 복귀
+//   loop.spawn(serveClient(fd, ...));                  // 다른 스레드에서도 호출 가능
+// 한 루프는 스레드 하나(run())에서만 돌고, 루프 밖 스레드는 post() 로만 들어온다.
+#pragma once
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace co {
+
+/* ───── Task<T>: 지연 시작, co_await 하면 실행되고 끝나면 호출자로 돌아간다 ───── */
+template <class T> class Task;
+
+namespace detail {
+struct FinalAwait {
+    bool await_ready() noexcept { return false; }
+    template <class P>
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<P> h) noexcept {
+        auto c = h.promise().cont;                         // 대칭 전환: 스택 없이 호출자 재개
+        return c ? c : std::noop_coroutine();
+    }
+    void await_resume() noexcept {}
+};
+struct PromiseBase {
+    std::coroutine_handle<> cont;
+    std::exception_ptr      ex;
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    FinalAwait final_suspend() noexcept { return {}; }
+    void unhandled_exception() { ex = std::current_exception(); }
+};
+template <class T> struct Promise : PromiseBase {
+    std::optional<T> value;
+    Task<T> get_return_object();
+    void return_value(T v) { value = std::move(v); }
+    T take() { if (ex) std::rethrow_exception(ex); return std::move(*value); }
+};
+template <> struct Promise<void> : PromiseBase {
+    Task<void> get_return_object();
+    void return_void() {}
+    void take() { if (ex) std::rethrow_exception(ex); }
+};
+}  // namespace detail
+
+template <class T = void>
+class Task {
+public:
+    using promise_type = detail::Promise<T>;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    explicit Task(Handle h) : h_(h) {}
+    Task(Task&& o) noexcept : h_(std::exchange(o.h_, {})) {}
+    Task(const Task&) = delete;
+    ~Task() { if (h_) h_.destroy(); }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> caller) noexcept {
+        h_.promise().cont = caller; return h_;
+    }
+    T await_resume() { return h_.promise().take(); }
+
+private:
+    Handle h_;
+};
+
+namespace detail {
+template <class T> Task<T> Promise<T>::get_return_object() { return Task<T>(Task<T>::Handle::from_promise(*this)); }
+inline Task<void> Promise<void>::get_return_object() { return Task<void>(Task<void>::Handle::from_promise(*this)); }
+
+// 최상위 코루틴: 끝나면 스스로 해제 (Task 프레임도 함께).
+// 빠져나온 예외는 그 코루틴만 끝낸다 (루프와 다른 코루틴은 계속). 자원 정리는 코루틴 쪽에서 잡아서 할 것
+struct Detached {
+    struct promise_type {
+        Detached get_return_object() { return {}; }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() noexcept {
+            try { throw; }
+            catch (const std::exception& e) { std::cerr << "co: uncaught exception in detached task: " << e.what() << '\n'; }
+            catch (...)                     { std::cerr << "co: uncaught exception in detached task\n"; }
+        }
+    };
+};
+inline Detached runDetached(Task<void> t) { co_await t; }
+}  // namespace detail
+
+/* ───── epoll 루프 ─────────────────────────────────────────────────────── */
+class EventLoop {
+public:
+    EventLoop() : ep_(epoll_create1(EPOLL_CLOEXEC)), wake_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+        epoll_event ev{}; ev.events = EPOLLIN; ev.data.ptr = nullptr;   // nullptr = post() 깨움
+        epoll_ctl(ep_, EPOLL_CTL_ADD, wake_, &ev);
+    }
+    EventLoop(const EventLoop&) = delete;
+
+    // 어느 스레드에서나: 루프 스레드에서 fn 실행
+    void post(std::function<void()> fn) {
+        { std::lock_guard<std::mutex> lk(m_); posted_.push_back(std::move(fn)); }
+        uint64_t one = 1; (void)!write(wake_, &one, 8);
+    }
+    void post(std::coroutine_handle<> h) { post([h]{ h.resume(); }); }
+
+    // 코루틴을 루프에서 시작하고 끝나면 해제
+    void spawn(Task<void> t) {
+        auto* p = new Task<void>(std::move(t));            // std::function 은 복사 가능해야 하므로 포인터로 넘김
+        post([p]{ Task<void> task(std::move(*p)); delete p; detail::runDetached(std::move(task)); });
+    }
+
+    // 루프 스레드에서 stop() 까지 돈다
+    void run() {
+        epoll_event evs[256];
+        while (!stop_) {
+            int n = epoll_wait(ep_, evs, 256, -1);
+            for (int i = 0; i < n; ++i) {
+                if (!evs[i].data.ptr) { uint64_t v; (void)!read(wake_, &v, 8); continue; }
+                std::coroutine_handle<>::from_address(evs[i].data.ptr).resume();
+            }
+            std::vector<std::function<void()>> todo;
+            { std::lock_guard<std::mutex> lk(m_); todo.swap(posted_); }
+            for (auto& fn : todo) fn();
+        }
+        { std::lock_guard<std::mutex> lk(m_); done_ = true; }
+        done_cv_.notify_all();
+    }
+
+    // 다른 스레드에서: 루프를 멈추고 run() 이 돌아올 때까지 기다린다 (돌던 코루틴은 이후 재개되지 않는다)
+    void stop() {
+        stop_ = true;
+        uint64_t one = 1; (void)!write(wake_, &one, 8);
+        std::unique_lock<std::mutex> lk(m_);
+        done_cv_.wait(lk, [&]{ return done_; });
+    }
+
+    /* ── fd 준비 대기 (EPOLLONESHOT: 깨어난 뒤 다시 기다리려면 다시 co_await) ── */
+    auto ready(int fd, uint32_t events) {
+        struct Await {
+            EventLoop& loop; int fd; uint32_t events;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) {
+                epoll_event ev{}; ev.events = events | EPOLLONESHOT | EPOLLRDHUP; ev.data.ptr = h.address();
+                if (loop.fds_.insert(fd).second) epoll_ctl(loop.ep_, EPOLL_CTL_ADD, fd, &ev);
+                else                              epoll_ctl(loop.ep_, EPOLL_CTL_MOD, fd, &ev);
+            }
+            void await_resume() const noexcept {}
+        };
+        return Await{*this, fd, events};
+    }
+
+    // 정확히 len 바이트 (연결 종료·오류면 false)
+    Task<bool> recvAll(int fd, void* buf, size_t len) {
+        char* p = (char*)buf;
+        while (len) {
+            ssize_t n = recv(fd, p, len, MSG_DONTWAIT);
+            if (n > 0) { p += n; len -= n; continue; }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) { co_await ready(fd, EPOLLIN); continue; }
+            if (n < 0 && errno == EINTR) continue;
+            co_return false;
+        }
+        co_return true;
+    }
+
+    Task<bool> sendAll(int fd, const void* buf, size_t len) {
+        const char* p = (const char*)buf;
+        while (len) {
+            ssize_t n = send(fd, p, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+            if (n > 0) { p += n; len -= n; continue; }
+            if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) { co_await ready(fd, EPOLLOUT); continue; }
+            if (n < 0 && errno == EINTR) continue;
+            co_return false;
+        }
+        co_return true;
+    }
+
+    // fn 을 pool(submit(std::function<void()>) 를 가진 스레드풀)에서 실행하고 결과를 들고 루프로 복귀.
+    // fn 이 던진 예외는 풀 스레드에서 잡아 두었다가 co_await 한 쪽에서 다시 던진다
+    template <class Pool, class F>
+    auto offload(Pool& pool, F fn) {
+        using R = std::invoke_result_t<F&>;
+        struct Await {
+            EventLoop& loop; Pool& pool; F fn; std::optional<R> out; std::exception_ptr ex;
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> h) {
+                pool.submit([this, h]{
+                    try { out.emplace(fn()); } catch (...) { ex = std::current_exception(); }
+                    loop.post(h);
+                });
+            }
+            R await_resume() { if (ex) std::rethrow_exception(ex); return std::move(*out); }
+        };
+        return Await{*this, pool, std::move(fn), std::nullopt, nullptr};
+    }
+
+    // 루프가 관리하던 fd 정리 후 닫기
+    void close(int fd) {
+        if (fds_.erase(fd)) epoll_ctl(ep_, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+    }
+
+private:
+    int ep_, wake_;
+    std::mutex m_;
+    std::vector<std::function<void()>> posted_;
+    std::atomic<bool> stop_{false};
+    bool done_ = false;                                 // run() 이 돌아옴 (m_ 보호)
+    std::condition_variable done_cv_;
+    std::unordered_set<int> fds_;                       // 루프 스레드 전용
+};
+
+}  // namespace co
@@ -0,0 +1,196 @@
+// det_delta.hpp
+// 검출 결과 델타 인코딩 (핸드셰이크 enc=delta). 추적 중인 느린 장면은 프레임 N 의 결과가 N-1 과 거의 같으므로
+// 직전에 보낸 목록 대비 사라진·움직인·새 박스만 보낸다. 좌표 차는 zigzag varint 라 대부분 1바이트.
+// keyframe 장마다(또는 델타가 전체보다 클 때) 전체 목록을 보내 다시 맞춘다.
+//   ddelta::Encoder enc(30);  enc.encode(boxes, msg);        // 서버: 연결마다 하나
+//   ddelta::Decoder dec;      dec.decode(msg.data(), msg.size(), boxes);   // 클라이언트
+// 메시지 (정수는 varint, 좌표·차이는 zigzag):
+//   Key   : [u8 0][n] n×[x][y][w][h][cls]
+//   Delta : [u8 1][삭제 수] 직전 목록 인덱스 (증가분)…
+//                 [이동 수] [인덱스 증가분][dx][dy][dw][dh]…
+//                 [추가 수] [x][y][w][h][cls]…
+// 새 목록 = 직전 목록에서 삭제된 것을 뺀 순서 그대로 (이동한 것은 갱신) + 추가된 것.
+// 양쪽이 같은 목록을 들고 있으므로 박스 순서가 프레임 사이에 유지된다 (클라이언트 쪽 추적에도 편함).
+// TCP 응답은 순서대로 빠짐없이 도착하므로 직전에 보낸 결과 = 클라이언트가 받은 직전 결과.
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ddelta {
+
+constexpr int      KEYFRAME  = 30;                // 기본 keyframe 간격 (프레임)
+constexpr float    MATCH_IOU = 0.3f;              // 같은 박스로 볼 최소 IoU (같은 클래스끼리)
+constexpr uint32_t MAX_BOXES = 4096;              // 디코더가 받아들이는 목록 크기 상한
+
+enum Kind : uint8_t { Key = 0, Delta = 1 };
+
+struct Box { int32_t x, y, w, h, cls; };
+
+inline bool operator==(const Box& a, const Box& b) {
+    return a.x == b.x && a.y == b.y && a.w == b.w && a.h == b.h && a.cls == b.cls;
+}
+
+inline uint64_t zigzag(int64_t v)    { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+inline int64_t  unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+inline void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) { out.push_back((uint8_t)(v | 0x80)); v >>= 7; }
+    out.push_back((uint8_t)v);
+}
+
+// 범위를 넘거나 10바이트가 넘으면 false (받은 데이터는 믿지 않는다)
+inline bool getVarint(const uint8_t*& p, const uint8_t* end, uint64_t& v) {
+    v = 0;
+    for (int s = 0; s < 64 && p < end; s += 7) {
+        const uint8_t b = *p++;
+        v |= (uint64_t)(b & 0x7f) << s;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+inline void putBox(std::vector<uint8_t>& out, const Box& b) {
+    putVarint(out, zigzag(b.x)); putVarint(out, zigzag(b.y));
+    putVarint(out, zigzag(b.w)); putVarint(out, zigzag(b.h));
+    putVarint(out, (uint64_t)b.cls);
+}
+
+inline bool getBox(const uint8_t*& p, const uint8_t* end, Box& b) {
+    uint64_t v[5];
+    for (auto& x : v) if (!getVarint(p, end, x)) return false;
+    b = {(int32_t)unzigzag(v[0]), (int32_t)unzigzag(v[1]), (int32_t)unzigzag(v[2]), (int32_t)unzigzag(v[3]), (int32_t)v[4]};
+    return true;
+}
+
+inline float iou(const Box& a, const Box& b) {
+    const int64_t ix = std::max(0, std::min(a.x + a.w, b.x + b.w) - std::max(a.x, b.x));
+    const int64_t iy = std::max(0, std::min(a.y + a.h, b.y + b.h) - std::max(a.y, b.y));
+    const int64_t in = ix * iy, un = (int64_t)a.w * a.h + (int64_t)b.w * b.h - in;
+    return un > 0 ? (float)in / un : 0.f;
+}
+
+/* ───── 서버: 연결마다 하나 (스레드 하나에서만) ─────────────────────────── */
+class Encoder {
+public:
+    explicit Encoder(int keyframe = KEYFRAME) : keyframe_(std::max(1, keyframe)) {}
+
+    // cur → out (메시지 한 개, out 은 덮어쓴다). 보낸 목록이 다음 프레임의 기준이 된다
+    void encode(const std::vector<Box>& cur, std::vector<uint8_t>& out) {
+        key_.clear();
+        key_.push_back(Key);
+        putVarint(key_, cur.size());
+        for (const auto& b : cur) putBox(key_, b);
+
+        if (have_ && ++since_key_ < keyframe_) {
+            buildDelta(cur);
+            if (delta_.size() < key_.size()) {     // 장면이 바뀌어 델타가 더 크면 keyframe
+                out.swap(delta_); prev_.swap(next_); ++deltas;
+                return;
+            }
+        }
+        out.swap(key_); prev_ = cur; ++keys;
+        have_ = true; since_key_ = 0;
+    }
+
+    uint64_t keys = 0, deltas = 0;
+
+private:
+    // 같은 클래스끼리 IoU 가 가장 큰 직전 박스와 짝짓는다 (탐욕, 검출 수가 적어 n×m 으로 충분)
+    void buildDelta(const std::vector<Box>& cur) {
+        match_.assign(prev_.size(), -1);
+        added_.clear();
+        for (size_t i = 0; i < cur.size(); ++i) {
+            int best = -1; float best_iou = MATCH_IOU;
+            for (size_t j = 0; j < prev_.size(); ++j) {
+                if (match_[j] >= 0 || prev_[j].cls != cur[i].cls) continue;
+                const float v = cur[i] == prev_[j] ? 2.f : iou(cur[i], prev_[j]);   // 그대로인 박스 우선
+                if (v >= best_iou) { best_iou = v; best = (int)j; }
+            }
+            if (best >= 0) match_[best] = (int)i; else added_.push_back((int)i);
+        }
+
+        delta_.clear(); next_.clear();
+        delta_.push_back(Delta);
+        size_t n = 0;
+        for (int m : match_) n += m < 0;
+        putVarint(delta_, n);
+        for (size_t j = 0, last = 0; j < prev_.size(); ++j)
+            if (match_[j] < 0) { putVarint(delta_, j - last); last = j; }
+
+        n = 0;
+        for (size_t j = 0; j < prev_.size(); ++j) n += match_[j] >= 0 && !(cur[match_[j]] == prev_[j]);
+        putVarint(delta_, n);
+        for (size_t j = 0, last = 0; j < prev_.size(); ++j) {
+            if (match_[j] < 0) continue;
+            const Box& a = prev_[j]; const Box& b = cur[match_[j]];
+            next_.push_back(b);
+            if (b == a) continue;
+            putVarint(delta_, j - last); last = j;
+            putVarint(delta_, zigzag((int64_t)b.x - a.x)); putVarint(delta_, zigzag((int64_t)b.y - a.y));
+            putVarint(delta_, zigzag((int64_t)b.w - a.w)); putVarint(delta_, zigzag((int64_t)b.h - a.h));
+        }
+
+        putVarint(delta_, added_.size());
+        for (int i : added_) { putBox(delta_, cur[i]); next_.push_back(cur[i]); }
+    }
+
+    int  keyframe_, since_key_ = 0;
+    bool have_ = false;
+    std::vector<Box> prev_, next_;
+    std::vector<int> match_, added_;
+    std::vector<uint8_t> key_, delta_;
+};
+
+/* ───── 클라이언트: 연결마다 하나 ───────────────────────────────────────── */
+class Decoder {
+public:
+    // 메시지 한 개 → out (서버가 들고 있는 것과 같은 목록). 깨진 메시지면 false
+    bool decode(const uint8_t* p, size_t n, std::vector<Box>& out) {
+        const uint8_t* end = p + n;
+        if (p == end) return false;
+        const uint8_t kind = *p++;
+        uint64_t cnt, v;
+        if (kind == Key) {
+            if (!getVarint(p, end, cnt) || cnt > MAX_BOXES) return false;
+            cur_.resize(cnt);
+            for (auto& b : cur_) if (!getBox(p, end, b)) return false;
+            have_ = true;
+        } else if (kind == Delta && have_) {
+            next_ = cur_;
+            keep_.assign(cur_.size(), 1);
+            if (!getVarint(p, end, cnt) || cnt > cur_.size()) return false;
+            for (uint64_t k = 0, j = 0; k < cnt; ++k) {          // 삭제
+                if (!getVarint(p, end, v) || (j += v) >= cur_.size()) return false;
+                keep_[j] = 0;
+            }
+            if (!getVarint(p, end, cnt) || cnt > cur_.size()) return false;
+            for (uint64_t k = 0, j = 0; k < cnt; ++k) {          // 이동
+                uint64_t d[4];
+                if (!getVarint(p, end, v) || (j += v) >= cur_.size()) return false;
+                for (auto& x : d) if (!getVarint(p, end, x)) return false;
+                Box& b = next_[j];
+                b.x += (int32_t)unzigzag(d[0]); b.y += (int32_t)unzigzag(d[1]);
+                b.w += (int32_t)unzigzag(d[2]); b.h += (int32_t)unzigzag(d[3]);
+            }
+            cur_.clear();
+            for (size_t j = 0; j < next_.size(); ++j) if (keep_[j]) cur_.push_back(next_[j]);
+            if (!getVarint(p, end, cnt) || cur_.size() + cnt > MAX_BOXES) return false;
+            for (uint64_t k = 0; k < cnt; ++k) {                 // 추가
+                Box b; if (!getBox(p, end, b)) return false;
+                cur_.push_back(b);
+            }
+        } else return false;                                      // keyframe 전의 델타
+        if (p != end) return false;
+        out = cur_;
+        return true;
+    }
+
+private:
+    bool have_ = false;
+    std::vector<Box> cur_, next_;
+    std::vector<uint8_t> keep_;
+};
+
+}  // namespace ddelta
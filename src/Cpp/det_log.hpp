@@ -0,0 +1,253 @@
+// det_log.hpp
+// 스트림별 검출 로그 (append-only, 컬럼 블록).
+//  - 쓰기: DetLogWriter::append() 는 메모리 배치에만 넣고, 백그라운드 스레드가
+//          블록 단위로 인코딩해 write + fdatasync 한다 (추론 경로에서 I/O 없음).
+//  - 읽기: DetLogReader 가 파일을 mmap 해서 시간 범위 스캔 / 클래스별 집계.
+//
+// 파일 = BlockHeader + payload 의 반복. payload(압축 전)는
+//   [u32 컬럼 오프셋 × NUM_COLS][frame][ts][x][y][w][h][cls][score][track]
+// 정수 컬럼은 직전 행과의 차이를 zigzag varint 로, score 는 float32 그대로.
+// <lz4.h> 가 있으면 payload 를 LZ4 로 압축한다 (codec=1).
+#pragma once
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if __has_include(<lz4.h>)
+#  include <lz4.h>
+#  define DET_LOG_LZ4 1
+#endif
+
+struct DetRow {
+    uint64_t frame_id;
+    int64_t  ts_us;            // 수신 시각 (epoch µs)
+    int32_t  x, y, w, h;
+    int32_t  cls;
+    float    score;
+    int32_t  track_id;         // 추적기가 없으면 -1
+};
+
+namespace detlog {
+
+constexpr uint32_t MAGIC    = 0x31424C44;   // "DLB1"
+constexpr int      NUM_COLS = 9;
+enum Col { FRAME, TS, X, Y, W, H, CLS, SCORE, TRACK };
+
+struct BlockHeader {
+    uint32_t magic;
+    uint32_t rows;
+    int64_t  ts_min, ts_max;
+    uint32_t raw_size, stored_size;
+    uint8_t  codec;            // 0 = 무압축, 1 = LZ4
+    uint8_t  pad[7];
+};
+static_assert(sizeof(BlockHeader) == 40, "BlockHeader layout");
+
+inline uint64_t zigzag(int64_t v)   { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+inline int64_t  unzigzag(uint64_t v){ return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+inline void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) { out.push_back(uint8_t(v) | 0x80); v >>= 7; }
+    out.push_back(uint8_t(v));
+}
+inline uint64_t getVarint(const uint8_t*& p) {
+    uint64_t v = 0; int shift = 0;
+    while (*p & 0x80) { v |= uint64_t(*p++ & 0x7F) << shift; shift += 7; }
+    return v | (uint64_t(*p++) << shift);
+}
+
+// 행 묶음 → 컬럼 블록 (헤더 포함) 을 out 뒤에 덧붙인다
+inline void encodeBlock(const std::vector<DetRow>& rows, std::vector<uint8_t>& out)
+{
+    std::vector<uint8_t> col[NUM_COLS];
+    DetRow prev{}; int64_t ts_min = INT64_MAX, ts_max = INT64_MIN;
+    for (const auto& r : rows) {
+        putVarint(col[FRAME], zigzag((int64_t)(r.frame_id - prev.frame_id)));
+        putVarint(col[TS],    zigzag(r.ts_us - prev.ts_us));
+        putVarint(col[X],     zigzag((int64_t)r.x - prev.x));
+        putVarint(col[Y],     zigzag((int64_t)r.y - prev.y));
+        putVarint(col[W],     zigzag((int64_t)r.w - prev.w));
+        putVarint(col[H],     zigzag((int64_t)r.h - prev.h));
+        putVarint(col[CLS],   (uint64_t)r.cls);
+        const uint8_t* s = (const uint8_t*)&r.score; col[SCORE].insert(col[SCORE].end(), s, s + 4);
+        putVarint(col[TRACK], zigzag((int64_t)r.track_id - prev.track_id));
+        ts_min = std::min(ts_min, r.ts_us); ts_max = std::max(ts_max, r.ts_us);
+        prev = r;
+    }
+
+    std::vector<uint8_t> raw(NUM_COLS * 4);
+    for (int c = 0; c < NUM_COLS; ++c) {
+        uint32_t off = (uint32_t)raw.size(); std::memcpy(&raw[c * 4], &off, 4);
+        raw.insert(raw.end(), col[c].begin(), col[c].end());
+    }
+
+    BlockHeader h{}; h.magic = MAGIC; h.rows = (uint32_t)rows.size();
+    h.ts_min = ts_min; h.ts_max = ts_max; h.raw_size = (uint32_t)raw.size();
+    const uint8_t* payload = raw.data(); h.stored_size = h.raw_size;
+#ifdef DET_LOG_LZ4
+    std::vector<uint8_t> comp(LZ4_compressBound((int)raw.size()));
+    int n = LZ4_compress_default((const char*)raw.data(), (char*)comp.data(), (int)raw.size(), (int)comp.size());
+    if (n > 0 && (uint32_t)n < h.raw_size) { h.codec = 1; h.stored_size = (uint32_t)n; payload = comp.data(); }
+#endif
+    const uint8_t* hp = (const uint8_t*)&h;
+    out.insert(out.end(), hp, hp + sizeof(h));
+    out.insert(out.end(), payload, payload + h.stored_size);
+}
+
+} // namespace detlog
+
+/* ───── 쓰기: 백그라운드 배치 writer ──────────────────────────────────── */
+class DetLogWriter {
+public:
+    static constexpr size_t BLOCK_ROWS = 4096;                  // 블록당 최대 행 수
+    static constexpr auto   FLUSH_EVERY = std::chrono::seconds(1);
+
+    explicit DetLogWriter(std::string dir) : dir_(std::move(dir)), th_([this]{ loop(); }) {}
+
+    // 남은 배치를 모두 기록하고 종료
+    ~DetLogWriter() {
+        { std::lock_guard<std::mutex> lk(m_); stop_ = true; }
+        cv_.notify_one(); th_.join();
+    }
+
+    void append(const std::string& stream, std::vector<DetRow> rows) {
+        if (rows.empty()) return;
+        std::lock_guard<std::mutex> lk(m_);
+        auto& pend = pending_[stream];
+        pend.insert(pend.end(), rows.begin(), rows.end());
+        if (pend.size() >= BLOCK_ROWS) cv_.notify_one();
+    }
+
+private:
+    void loop() {
+        std::map<std::string, int> fds;
+        for (bool last = false; !last; ) {
+            std::map<std::string, std::vector<DetRow>> batch;
+            {   std::unique_lock<std::mutex> lk(m_);
+                if (!stop_) cv_.wait_for(lk, FLUSH_EVERY);
+                batch.swap(pending_); last = stop_;
+            }
+            for (auto& kv : batch) {
+                int& fd = fds.emplace(kv.first, -1).first->second;
+                if (fd < 0) {
+                    std::string path = dir_ + "/" + kv.first + ".dlog";
+                    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+                    if (fd < 0) { perror(path.c_str()); continue; }
+                }
+                std::vector<uint8_t> out;
+                for (size_t i = 0; i < kv.second.size(); i += BLOCK_ROWS) {
+                    std::vector<DetRow> blk(kv.second.begin() + i,
+                                            kv.second.begin() + std::min(kv.second.size(), i + BLOCK_ROWS));
+                    detlog::encodeBlock(blk, out);
+                }
+                const uint8_t* p = out.data(); size_t l = out.size();
+                while (l) { ssize_t n = ::write(fd, p, l); if (n <= 0) { perror("detlog write"); break; } p += n; l -= n; }
+                fdatasync(fd);
+            }
+        }
+        for (auto& kv : fds) if (kv.second >= 0) ::close(kv.second);
+    }
+
+    std::string dir_;
+    std::mutex m_; std::condition_variable cv_;
+    std::map<std::string, std::vector<DetRow>> pending_;
+    bool        stop_ = false;
+    std::thread th_;                                           // 마지막에 초기화 (다른 멤버 준비 후 시작)
+};
+
+/* ───── 읽기: mmap 기반 질의 ─────────────────────────────────────────── */
+class DetLogReader {
+public:
+    ~DetLogReader() { if (base_) munmap((void*)base_, size_); }
+
+    bool open(const std::string& path) {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) { perror(path.c_str()); return false; }
+        struct stat st{}; fstat(fd, &st); size_ = (size_t)st.st_size;
+        if (size_) base_ = (const uint8_t*)mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (base_ == MAP_FAILED) { base_ = nullptr; perror("mmap"); return false; }
+        return true;
+    }
+
+    // [t0, t1] 범위의 모든 행에 fn(const DetRow&) 호출
+    template <class F> void scan(int64_t t0, int64_t t1, F&& fn) const {
+        forBlocks(t0, t1, [&](const detlog::BlockHeader& h, const uint8_t* raw){
+            const uint8_t* c[detlog::NUM_COLS];
+            for (int i = 0; i < detlog::NUM_COLS; ++i) { uint32_t off; std::memcpy(&off, raw + i*4, 4); c[i] = raw + off; }
+            DetRow r{};
+            for (uint32_t k = 0; k < h.rows; ++k) {
+                r.frame_id += (uint64_t)detlog::unzigzag(detlog::getVarint(c[detlog::FRAME]));
+                r.ts_us    += detlog::unzigzag(detlog::getVarint(c[detlog::TS]));
+                r.x        += (int32_t)detlog::unzigzag(detlog::getVarint(c[detlog::X]));
+                r.y        += (int32_t)detlog::unzigzag(detlog::getVarint(c[detlog::Y]));
+                r.w        += (int32_t)detlog::unzigzag(detlog::getVarint(c[detlog::W]));
+                r.h        += (int32_t)detlog::unzigzag(detlog::getVarint(c[detlog::H]));
+                r.cls       = (int32_t)detlog::getVarint(c[detlog::CLS]);
+                std::memcpy(&r.score, c[detlog::SCORE], 4); c[detlog::SCORE] += 4;
+                r.track_id += (int32_t)detlog::unzigzag(detlog::getVarint(c[detlog::TRACK]));
+                if (r.ts_us >= t0 && r.ts_us <= t1) fn(r);
+            }
+        });
+    }
+
+    // [t0, t1] 범위의 클래스별 검출 수 (ts·cls 컬럼만 디코드)
+    std::map<int, uint64_t> classCounts(int64_t t0, int64_t t1) const {
+        std::map<int, uint64_t> counts;
+        forBlocks(t0, t1, [&](const detlog::BlockHeader& h, const uint8_t* raw){
+            uint32_t off_ts, off_cls;
+            std::memcpy(&off_ts, raw + detlog::TS*4, 4); std::memcpy(&off_cls, raw + detlog::CLS*4, 4);
+            const uint8_t* pt = raw + off_ts; const uint8_t* pc = raw + off_cls;
+            const bool whole = h.ts_min >= t0 && h.ts_max <= t1;
+            int64_t ts = 0;
+            for (uint32_t k = 0; k < h.rows; ++k) {
+                ts += detlog::unzigzag(detlog::getVarint(pt));
+                int cls = (int)detlog::getVarint(pc);
+                if (whole || (ts >= t0 && ts <= t1)) ++counts[cls];
+            }
+        });
+        return counts;
+    }
+
+private:
+    // 시간 범위가 겹치는 블록만 (필요하면 압축 해제해서) fn(header, raw) 호출
+    template <class F> void forBlocks(int64_t t0, int64_t t1, F&& fn) const {
+        std::vector<uint8_t> buf;
+        size_t pos = 0;
+        while (pos + sizeof(detlog::BlockHeader) <= size_) {
+            detlog::BlockHeader h; std::memcpy(&h, base_ + pos, sizeof(h));
+            const uint8_t* payload = base_ + pos + sizeof(h);
+            if (h.magic != detlog::MAGIC || pos + sizeof(h) + h.stored_size > size_) break;   // 잘린 꼬리
+            pos += sizeof(h) + h.stored_size;
+            if (h.ts_max < t0 || h.ts_min > t1) continue;
+
+            const uint8_t* raw = payload;
+            if (h.codec == 1) {
+#ifdef DET_LOG_LZ4
+                buf.resize(h.raw_size);
+                if (LZ4_decompress_safe((const char*)payload, (char*)buf.data(), (int)h.stored_size, (int)h.raw_size) != (int)h.raw_size) continue;
+                raw = buf.data();
+#else
+                std::fprintf(stderr, "detlog: LZ4 block but built without lz4\n"); continue;
+#endif
+            }
+            fn(h, raw);
+        }
+    }
+
+    const uint8_t* base_ = nullptr;
+    size_t         size_ = 0;
+};
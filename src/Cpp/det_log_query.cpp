@@ -0,0 +1,41 @@
+// det_log_query.cpp
+// draw_server_async_01 --detlog=DIR 로 쌓인 <stream>.dlog 를 mmap 으로 읽어
+// 시간 범위의 클래스별 검출 수(기본) 또는 행 전체(--rows)를 출력한다.
+// 빌드: g++ -std=c++17 -O2 det_log_query.cpp -o det_log_query   (LZ4 로그면 -llz4 추가)
+// 실행: ./det_log_query cam1.dlog [시작_us] [끝_us] [--rows]
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "det_log.hpp"
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) { std::cerr << "Usage: " << argv[0] << " <stream.dlog> [t0_us] [t1_us] [--rows]\n"; return 1; }
+
+    bool rows = false; int64_t t[2] = {INT64_MIN, INT64_MAX}; int nt = 0;
+    for (int i = 2; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--rows") == 0) rows = true;
+        else if (nt < 2) t[nt++] = std::stoll(argv[i]);
+    }
+
+    DetLogReader log;
+    if (!log.open(argv[1])) return 1;
+
+    if (rows) {
+        std::cout << "frame_id,ts_us,x,y,w,h,cls,score,track_id\n";
+        log.scan(t[0], t[1], [](const DetRow& r){
+            std::cout << r.frame_id << ',' << r.ts_us << ',' << r.x << ',' << r.y << ',' << r.w << ','
+                      << r.h << ',' << r.cls << ',' << r.score << ',' << r.track_id << '\n';
+        });
+        return 0;
+    }
+
+    uint64_t total = 0;
+    for (const auto& kv : log.classCounts(t[0], t[1])) {
+        std::cout << "cls " << kv.first << " : " << kv.second << '\n';
+        total += kv.second;
+    }
+    std::cout << "total : " << total << '\n';
+    return 0;
+}
@@ -0,0 +1,317 @@
+// draw_client.cpp
+// drawc::Client 구현. 소켓은 I/O 스레드 하나가 non-blocking 으로 돌리고,
+// submit 쪽과는 to_send_ / waiting_ 큐(m_ 보호)와 eventfd 깨움으로만 만난다.
+#include "draw_client.hpp"
+
+#include <arpa/inet.h>
+#include <endian.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <regex>
+#include <sstream>
+#include <stdexcept>
+
+namespace drawc {
+
+namespace {
+constexpr uint32_t HELLO_MAGIC = 0x44525731;      // "DRW1" (서버와 같아야 함)
+constexpr size_t   RX_CHUNK    = 64 << 10;
+constexpr uint32_t MAX_JPEG    = 64u << 20;       // render=jpeg 응답 길이 상한
+constexpr uint32_t MAX_DELTA   = 1u << 20;        // enc=delta 메시지 길이 상한
+
+int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// 연결 직후 핸드셰이크는 blocking 으로 (I/O 스레드 시작 전)
+void sendBlocking(int fd, const void* p, size_t n) {
+    const char* c = (const char*)p;
+    while (n) {
+        ssize_t k = send(fd, c, n, MSG_NOSIGNAL);
+        if (k < 0 && errno == EINTR) continue;
+        if (k <= 0) throw std::runtime_error(std::string("drawc: send: ") + strerror(errno));
+        c += k; n -= k;
+    }
+}
+}  // namespace
+
+std::vector<Det> parseResult(const std::string& line) {
+    std::vector<int> v;
+    const char* p = line.c_str();
+    while (*p) {
+        if (*p == '-' || (*p >= '0' && *p <= '9')) { char* e; v.push_back((int)std::strtol(p, &e, 10)); p = e; }
+        else ++p;
+    }
+    std::vector<Det> out;
+    for (size_t i = 0; i + 5 <= v.size(); i += 5) out.push_back({v[i], v[i + 1], v[i + 2], v[i + 3], v[i + 4]});
+    return out;
+}
+
+Client::Client(const Options& opt) : opt_(opt) {
+    if (opt_.depth < 1) opt_.depth = 1;
+    addrinfo hints{}, *res = nullptr;
+    hints.ai_family = AF_UNSPEC; hints.ai_socktype = SOCK_STREAM;
+    if (getaddrinfo(opt_.host.c_str(), std::to_string(opt_.port).c_str(), &hints, &res) != 0 || !res)
+        throw std::runtime_error("drawc: cannot resolve " + opt_.host);
+    for (addrinfo* a = res; a && fd_ < 0; a = a->ai_next) {
+        fd_ = socket(a->ai_family, a->ai_socktype | SOCK_CLOEXEC, a->ai_protocol);
+        if (fd_ >= 0 && connect(fd_, a->ai_addr, a->ai_addrlen) != 0) { ::close(fd_); fd_ = -1; }
+    }
+    freeaddrinfo(res);
+    if (fd_ < 0) throw std::runtime_error("drawc: cannot connect to " + opt_.host + ":" + std::to_string(opt_.port));
+    int one = 1; setsockopt(fd_, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    /* ── 핸드셰이크 (설정이 없으면 구버전 방식: 바로 프레임) ── */
+    auto kv = opt_.stream;
+    if (opt_.timestamps) kv["ts"] = "1";
+    if (!opt_.frame_size.empty())
+        kv["frame"] = std::to_string(opt_.frame_size.width) + "x" + std::to_string(opt_.frame_size.height);
+    if (!kv.empty()) {
+        std::string text;
+        for (auto& [k, v] : kv) text += (text.empty() ? "" : " ") + k + "=" + v;
+        uint32_t h[2] = {htonl(HELLO_MAGIC), htonl((uint32_t)text.size())};
+        try {
+            sendBlocking(fd_, h, sizeof(h));
+            sendBlocking(fd_, text.data(), text.size());
+            for (char c; ack_.empty() || ack_.back() != '\n'; ack_ += c)
+                if (recv(fd_, &c, 1, 0) != 1) throw std::runtime_error("drawc: handshake rejected");
+        } catch (...) { ::close(fd_); throw; }
+        if (ack_.rfind("ok", 0) != 0) { ::close(fd_); throw std::runtime_error("drawc: handshake: " + ack_); }
+        ts_ = ack_.find(" ts=1") != std::string::npos;
+        delta_ = ack_.find(" enc=delta") != std::string::npos;
+        std::smatch m;
+        if (std::regex_search(ack_, m, std::regex(R"(\bfit=(\d+)x(\d+))")) && m[1] != "0")
+            fit_ = cv::Size(std::stoi(m[1]), std::stoi(m[2]));
+    }
+    render_jpeg_ = kv.count("render") && kv["render"] == "jpeg";
+
+    fcntl(fd_, F_SETFL, fcntl(fd_, F_GETFL) | O_NONBLOCK);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    io_ = std::thread([this] { ioLoop(); });
+}
+
+Client::~Client() { close(); }
+
+void Client::close() {
+    {   std::lock_guard<std::mutex> lk(m_);
+        if (fd_ < 0) return;
+    }
+    fail("drawc: client closed");
+    wake();
+    if (io_.joinable()) io_.join();
+    ::close(fd_); ::close(wake_fd_);
+    fd_ = wake_fd_ = -1;
+}
+
+size_t Client::inFlight() const {
+    std::lock_guard<std::mutex> lk(m_);
+    return to_send_.size() + waiting_.size();
+}
+
+std::unique_ptr<std::vector<uint8_t>> Client::takeBuffer() {
+    std::lock_guard<std::mutex> lk(m_);
+    if (free_bufs_.empty()) return std::make_unique<std::vector<uint8_t>>();
+    auto b = std::move(free_bufs_.back());
+    free_bufs_.pop_back();
+    return b;
+}
+
+// m_ 잡은 상태에서
+void Client::giveBuffer(std::unique_ptr<std::vector<uint8_t>> b) {
+    if (free_bufs_.size() < (size_t)opt_.depth + 1) free_bufs_.push_back(std::move(b));
+}
+
+namespace {
+std::future<Detections> failedFuture(const char* why) {
+    std::promise<Detections> p;
+    p.set_exception(std::make_exception_ptr(std::runtime_error(why)));
+    return p.get_future();
+}
+}  // namespace
+
+std::future<Detections> Client::submit(const cv::Mat& frame) {
+    if (frame.empty()) return failedFuture("drawc: empty frame");   // resize 가 던지기 전에
+    const int64_t cap_us = nowUs();
+    // 줄여 보낼 때 쓰는 중간 영상도 스레드마다 재사용
+    thread_local cv::Mat small;
+    // 인코딩 결과는 재사용 버퍼에 바로 쓰고, 송신도 그 버퍼에서 (헤더와 writev)
+    auto buf = takeBuffer();
+    bool ok = false;
+    try {
+        const cv::Mat* img = &frame;
+        if (!fit_.empty() && frame.size() != fit_) {
+            cv::resize(frame, small, fit_, 0, 0, cv::INTER_AREA);
+            img = &small;
+        }
+        ok = cv::imencode(".jpg", *img, *buf, {cv::IMWRITE_JPEG_QUALITY, opt_.jpeg_quality});
+    } catch (const cv::Exception&) {}             // 지원하지 않는 형식 (채널 수·깊이) 도 실패한 future 로
+    if (!ok) {
+        { std::lock_guard<std::mutex> lk(m_); giveBuffer(std::move(buf)); }
+        return failedFuture("drawc: jpeg encode failed");
+    }
+    return enqueue(std::move(buf), cap_us);
+}
+
+std::future<Detections> Client::submitJpeg(const uint8_t* data, size_t len) {
+    auto buf = takeBuffer();
+    buf->assign(data, data + len);
+    return enqueue(std::move(buf), nowUs());
+}
+
+std::future<Detections> Client::enqueue(std::unique_ptr<std::vector<uint8_t>> jpg, int64_t cap_us) {
+    auto p = std::make_unique<Pending>();
+    auto fut = p->done.get_future();
+    uint32_t len_be = htonl((uint32_t)jpg->size());
+    p->hdr.assign((uint8_t*)&len_be, (uint8_t*)&len_be + 4);
+    if (ts_) {                                    // 송신 시각은 실제로 보내기 시작할 때 채운다
+        uint64_t c = htobe64((uint64_t)cap_us), z = 0;
+        p->hdr.insert(p->hdr.end(), (uint8_t*)&c, (uint8_t*)&c + 8);
+        p->hdr.insert(p->hdr.end(), (uint8_t*)&z, (uint8_t*)&z + 8);
+    }
+    p->jpg = std::move(jpg);
+    {   std::unique_lock<std::mutex> lk(m_);
+        room_.wait(lk, [&] { return closed_ || to_send_.size() + waiting_.size() < (size_t)opt_.depth; });
+        if (closed_) {
+            p->done.set_exception(std::make_exception_ptr(std::runtime_error(error_)));
+            giveBuffer(std::move(p->jpg));
+            return fut;
+        }
+        p->frame = ++next_frame_;
+        to_send_.push_back(std::move(p));
+    }
+    wake();
+    return fut;
+}
+
+void Client::wake() {
+    uint64_t one = 1;
+    if (wake_fd_ >= 0) (void)!write(wake_fd_, &one, 8);
+}
+
+void Client::fail(const std::string& why) {
+    std::lock_guard<std::mutex> lk(m_);
+    if (closed_) return;
+    closed_ = true; error_ = why;
+    for (auto* q : {&to_send_, &waiting_})
+        for (auto& p : *q) p->done.set_exception(std::make_exception_ptr(std::runtime_error(why)));
+    to_send_.clear(); waiting_.clear();
+    room_.notify_all();
+}
+
+bool Client::flushSend() {
+    std::lock_guard<std::mutex> lk(m_);
+    while (!to_send_.empty()) {
+        Pending& p = *to_send_.front();
+        if (p.sent == 0) {
+            p.t0_us = nowUs();
+            if (ts_) { uint64_t s = htobe64((uint64_t)p.t0_us); std::memcpy(p.hdr.data() + 12, &s, 8); }
+        }
+        iovec iov[2]; int n = 0;
+        const size_t hn = p.hdr.size(), total = hn + p.jpg->size();
+        if (p.sent < hn) iov[n++] = {p.hdr.data() + p.sent, hn - p.sent};
+        const size_t jo = p.sent > hn ? p.sent - hn : 0;
+        iov[n++] = {p.jpg->data() + jo, p.jpg->size() - jo};
+        msghdr mh{}; mh.msg_iov = iov; mh.msg_iovlen = n;
+        ssize_t k = sendmsg(fd_, &mh, MSG_NOSIGNAL | MSG_DONTWAIT);
+        if (k < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) return true;
+            return false;
+        }
+        p.sent += k;
+        if (p.sent < total) return true;          // 소켓 버퍼가 찼다 → POLLOUT 대기
+        giveBuffer(std::move(p.jpg));
+        waiting_.push_back(std::move(to_send_.front()));
+        to_send_.pop_front();
+    }
+    return true;
+}
+
+bool Client::readReplies() {
+    bool eof = false;
+    while (true) {
+        if (rx_.size() < rx_len_ + RX_CHUNK) rx_.resize(rx_len_ + RX_CHUNK);   // 늘리기만 (0 채우기는 처음 한 번)
+        ssize_t k = recv(fd_, rx_.data() + rx_len_, RX_CHUNK, MSG_DONTWAIT);
+        if (k > 0) { rx_len_ += k; continue; }
+        if (k < 0 && errno == EINTR) continue;
+        eof = k == 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+        break;
+    }
+    // 응답: 결과 한 줄, enc=delta 면 [u32 길이][델타] (+ render=jpeg 이면 [u32 길이][JPEG])
+    size_t pos = 0;
+    while (true) {
+        const uint8_t* beg = rx_.data() + pos;
+        size_t end;
+        if (delta_) {
+            if (rx_len_ < pos + 4) break;
+            uint32_t dn; std::memcpy(&dn, beg, 4); dn = ntohl(dn);
+            if (dn > MAX_DELTA) return false;
+            if (rx_len_ < pos + 4 + dn) break;
+            end = pos + 4 + dn;
+        } else {
+            const uint8_t* nl = (const uint8_t*)std::memchr(beg, '\n', rx_len_ - pos);
+            if (!nl) break;
+            end = nl - rx_.data() + 1;
+        }
+        uint32_t jn = 0;
+        if (render_jpeg_) {
+            if (rx_len_ < end + 4) break;
+            std::memcpy(&jn, rx_.data() + end, 4); jn = ntohl(jn);
+            if (jn > MAX_JPEG) return false;
+            if (rx_len_ < end + 4 + jn) break;
+        }
+        Detections d;
+        if (delta_) {
+            std::vector<ddelta::Box> boxes;
+            if (!delta_dec_.decode(beg + 4, end - pos - 4, boxes)) return false;   // 서버와 목록이 어긋남
+            for (const auto& b : boxes) d.dets.push_back({b.x, b.y, b.w, b.h, b.cls});
+        } else d.dets = parseResult(std::string((const char*)beg, rx_.data() + end - 1 - beg));
+        if (render_jpeg_) d.jpeg.assign(rx_.data() + end + 4, rx_.data() + end + 4 + jn);
+        pos = end + (render_jpeg_ ? 4 + jn : 0);
+
+        PendingPtr p;
+        {   std::lock_guard<std::mutex> lk(m_);
+            if (waiting_.empty()) return false;  // 보낸 적 없는 응답
+            p = std::move(waiting_.front());
+            waiting_.pop_front();
+            room_.notify_one();
+        }
+        d.frame = p->frame;
+        d.rtt_ms = (nowUs() - p->t0_us) / 1000.0;
+        p->done.set_value(std::move(d));
+    }
+    std::memmove(rx_.data(), rx_.data() + pos, rx_len_ - pos);
+    rx_len_ -= pos;
+    return !eof;
+}
+
+void Client::ioLoop() {
+    while (true) {
+        bool want_out;
+        {   std::lock_guard<std::mutex> lk(m_);
+            if (closed_) return;
+            want_out = !to_send_.empty();
+        }
+        pollfd pf[2] = {{fd_, (short)(POLLIN | (want_out ? POLLOUT : 0)), 0}, {wake_fd_, POLLIN, 0}};
+        if (poll(pf, 2, -1) < 0 && errno != EINTR) { fail(std::string("drawc: poll: ") + strerror(errno)); return; }
+        if (pf[1].revents & POLLIN) { uint64_t v; (void)!read(wake_fd_, &v, 8); }
+        if (!flushSend()) { fail(std::string("drawc: send: ") + strerror(errno)); return; }
+        if ((pf[0].revents & (POLLIN | POLLHUP | POLLERR)) && !readReplies()) { fail("drawc: connection lost"); return; }
+    }
+}
+
+}  // namespace drawc
@@ -0,0 +1,108 @@
+// draw_client.hpp
+// draw_server_async_01 용 C++ 클라이언트 라이브러리. 프레이밍·핸드셰이크·파이프라이닝을 한 곳에.
+//   drawc::Options o; o.host = "127.0.0.1"; o.port = 9999; o.stream = {{"priority", "0"}}; o.depth = 8;
+//   drawc::Client cli(o);                                 // 연결 + 핸드셰이크 (실패하면 std::runtime_error)
+//   std::future<drawc::Detections> f = cli.submit(frame); // 인코딩은 호출 스레드, 송수신은 I/O 스레드
+//   for (auto& d : f.get().dets) ...
+// 서버는 연결마다 프레임을 순서대로 처리하므로 응답도 보낸 순서로 온다. 응답을 기다리지 않고
+// depth 장까지 미리 보내 두어 왕복 지연 동안에도 서버가 놀지 않게 한다 (depth 가 차면 submit 이 대기).
+// submit 은 여러 스레드에서 불러도 된다. 연결이 끊기면 남은 future 는 모두 예외로 끝난다.
+#pragma once
+#include <opencv2/core.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "det_delta.hpp"
+
+namespace drawc {
+
+struct Det { int x, y, w, h, cls; };
+
+struct Detections {
+    uint64_t             frame = 0;               // submit 순번 (1부터)
+    std::vector<Det>     dets;                    // 원본 프레임 좌표
+    std::vector<uint8_t> jpeg;                    // render=jpeg 일 때 서버가 그린 프레임
+    double               rtt_ms = 0;              // submit → 응답
+};
+
+struct Options {
+    std::string host = "127.0.0.1";
+    int         port = 9999;
+    std::map<std::string, std::string> stream;   // 핸드셰이크 key=value (priority, deadline_ms, classes, render, enc=delta ...)
+    int         depth = 4;                       // 응답 없이 보내 둘 수 있는 프레임 수
+    int         jpeg_quality = 80;
+    cv::Size    frame_size;                      // 알려 주면 서버가 정한 크기(fit)로 줄여서 보낸다
+    bool        timestamps = false;              // ts=1 : 프레임 헤더에 촬영·송신 시각 (서버 --trace 용)
+};
+
+class Client {
+public:
+    explicit Client(const Options& opt);
+    ~Client();
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    // frame(BGR) 을 JPEG 로 인코딩해 보낼 차례에 넣는다. 응답이 오면 future 가 채워진다
+    std::future<Detections> submit(const cv::Mat& frame);
+    // 이미 인코딩된 JPEG (프레임 크기 협상은 호출자 몫)
+    std::future<Detections> submitJpeg(const uint8_t* data, size_t len);
+
+    const std::string& ack() const { return ack_; }     // 서버 "ok ..." 줄
+    cv::Size fit() const { return fit_; }                // 줄여 보내는 크기 (빈 크기 = 원본)
+    size_t inFlight() const;
+    void close();                                        // 보내 둔 프레임의 응답은 기다리지 않는다
+
+private:
+    struct Pending {
+        uint64_t frame = 0;
+        std::vector<uint8_t> hdr;                 // [u32 길이] (+ [u64 촬영 μs][u64 송신 μs])
+        std::unique_ptr<std::vector<uint8_t>> jpg;
+        size_t   sent = 0;                        // hdr + jpg 중 보낸 바이트
+        int64_t  t0_us = 0;
+        std::promise<Detections> done;
+    };
+    using PendingPtr = std::unique_ptr<Pending>;
+
+    std::future<Detections> enqueue(std::unique_ptr<std::vector<uint8_t>> jpg, int64_t cap_us);
+    std::unique_ptr<std::vector<uint8_t>> takeBuffer();
+    void giveBuffer(std::unique_ptr<std::vector<uint8_t>> b);
+    void ioLoop();
+    bool flushSend();                             // I/O 스레드: 보낼 수 있는 만큼 보낸다
+    bool readReplies();                           // I/O 스레드: 완성된 응답을 future 로
+    void fail(const std::string& why);
+    void wake();
+
+    Options     opt_;
+    int         fd_ = -1, wake_fd_ = -1;
+    std::string ack_;
+    cv::Size    fit_;
+    bool        ts_ = false, render_jpeg_ = false, delta_ = false;
+    ddelta::Decoder delta_dec_;                   // enc=delta: I/O 스레드 전용
+
+    mutable std::mutex m_;
+    std::condition_variable room_;                // in flight < depth
+    std::deque<PendingPtr> to_send_;              // 아직 다 못 보낸 것 (앞쪽부터)
+    std::deque<PendingPtr> waiting_;              // 다 보내고 응답 대기 (보낸 순서)
+    std::vector<std::unique_ptr<std::vector<uint8_t>>> free_bufs_;   // 재사용 JPEG 버퍼
+    uint64_t    next_frame_ = 0;
+    bool        closed_ = false;
+    std::string error_;
+
+    std::vector<uint8_t> rx_;                     // I/O 스레드 전용 수신 버퍼 (앞 rx_len_ 바이트가 유효)
+    size_t      rx_len_ = 0;
+    std::thread io_;
+};
+
+// 결과 줄 "[x,y,w,h,cls,...]" → Det 목록
+std::vector<Det> parseResult(const std::string& line);
+
+}  // namespace drawc
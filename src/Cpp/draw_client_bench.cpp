@@ -0,0 +1,88 @@
+// draw_client_bench.cpp
+// drawc::Client 로 서버를 최대 속도로 두드려 처리량·왕복 지연을 잰다.
+// 영상(또는 이미지)에서 프레임을 미리 읽어 두고, 연결마다 스레드 하나가 depth 장씩 파이프라인으로 보낸다.
+// 실행: ./draw_client_bench 127.0.0.1 9999 video.mp4 [--conns=4] [--depth=8] [--frames=1000] [--fit=1]
+//       [--priority=1] [--deadline_ms=0] [--classes=0,2] ...   (나머지 --key=value 는 핸드셰이크로)
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "draw_client.hpp"
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4) {
+        std::cerr << "Usage: " << argv[0] << " <host> <port> <video|image> [--conns=N] [--depth=D] [--frames=N] [--fit=1]"
+                     " [--key=value ...]\n";
+        return 1;
+    }
+    std::map<std::string, std::string> opt, stream;
+    for (int i = 4; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a.rfind("--", 0) != 0) continue;
+        auto eq = a.find('=');
+        std::string k = a.substr(2, eq == std::string::npos ? std::string::npos : eq - 2);
+        std::string v = eq == std::string::npos ? "1" : a.substr(eq + 1);
+        if (k == "conns" || k == "depth" || k == "frames" || k == "fit") opt[k] = v;
+        else stream[k] = v;
+    }
+    const int conns  = opt.count("conns")  ? std::max(1, std::stoi(opt["conns"]))  : 1;
+    const int depth  = opt.count("depth")  ? std::max(1, std::stoi(opt["depth"]))  : 4;
+    const int frames = opt.count("frames") ? std::max(1, std::stoi(opt["frames"])) : 500;
+
+    // 디코드 비용이 재는 값에 섞이지 않게 미리 읽어 둔다 (최대 64장을 돌려 씀)
+    std::vector<cv::Mat> src;
+    cv::VideoCapture cap(argv[3]);
+    for (cv::Mat f; src.size() < 64 && cap.read(f); ) src.push_back(f.clone());
+    if (src.empty()) { std::cerr << "❌ cannot read " << argv[3] << '\n'; return 1; }
+
+    drawc::Options o;
+    o.host = argv[1]; o.port = std::stoi(argv[2]); o.depth = depth; o.stream = stream;
+    if (opt.count("fit") && opt["fit"] != "0") o.frame_size = src[0].size();
+
+    std::mutex m; std::vector<double> rtts; std::atomic<long> errors{0};
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<std::thread> ths;
+    for (int c = 0; c < conns; ++c)
+        ths.emplace_back([&, c] {
+            try {
+                drawc::Client cli(o);
+                if (c == 0) std::cout << "🔵 " << cli.ack();
+                std::deque<std::future<drawc::Detections>> q;
+                std::vector<double> mine;
+                auto drain = [&] {
+                    try { mine.push_back(q.front().get().rtt_ms); } catch (const std::exception&) { ++errors; }
+                    q.pop_front();
+                };
+                for (int i = 0; i < frames; ++i) {
+                    q.push_back(cli.submit(src[(i + c) % src.size()]));   // depth 가 차면 여기서 대기
+                    if ((int)q.size() > depth) drain();
+                }
+                while (!q.empty()) drain();
+                std::lock_guard<std::mutex> lk(m);
+                rtts.insert(rtts.end(), mine.begin(), mine.end());
+            } catch (const std::exception& e) {
+                std::cerr << "❌ " << e.what() << '\n'; ++errors;
+            }
+        });
+    for (auto& t : ths) t.join();
+    const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    if (rtts.empty()) return 1;
+    std::sort(rtts.begin(), rtts.end());
+    double mean = 0; for (double r : rtts) mean += r; mean /= rtts.size();
+    std::printf("🟡 %zu frames / %.2fs = %.1f fps  (conns=%d depth=%d)  rtt mean %.1fms p50 %.1fms p99 %.1fms  errors=%ld\n",
+                rtts.size(), sec, rtts.size() / sec, conns, depth, mean,
+                rtts[rtts.size() / 2], rtts[std::min(rtts.size() - 1, rtts.size() * 99 / 100)], errors.load());
+    return 0;
+}
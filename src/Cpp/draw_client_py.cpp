@@ -0,0 +1,76 @@
+// draw_client_py.cpp
+// drawc::Client 의 파이썬 바인딩 (pybind11, 선택 빌드). 파이썬 프로듀서도 프레이밍을 다시 짜지 않고
+// 인코딩·송수신을 GIL 밖에서 돌린다.
+//   import drawc
+//   cli = drawc.Client("127.0.0.1", 9999, {"priority": "0"}, depth=8)
+//   p = cli.submit(frame)            # numpy uint8 HxWx3 BGR, 바로 반환
+//   boxes = p.result()               # [(x, y, w, h, cls), ...]  (render=jpeg 면 p.jpeg 에 bytes)
+#include <pybind11/numpy.h>
+#include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
+
+#include <opencv2/core.hpp>
+
+#include "draw_client.hpp"
+
+namespace py = pybind11;
+
+namespace {
+struct Pending {
+    std::shared_future<drawc::Detections> f;
+
+    py::list result() {
+        const drawc::Detections* d;
+        {   py::gil_scoped_release nogil;
+            d = &f.get();
+        }
+        py::list out;
+        for (const auto& b : d->dets) out.append(py::make_tuple(b.x, b.y, b.w, b.h, b.cls));
+        return out;
+    }
+    bool done() const { return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready; }
+    py::bytes jpeg() {
+        const auto& j = f.get().jpeg;
+        return py::bytes((const char*)j.data(), j.size());
+    }
+};
+}  // namespace
+
+PYBIND11_MODULE(drawc, m) {
+    m.doc() = "draw_server_async_01 client (pipelined, background I/O thread)";
+
+    py::class_<Pending>(m, "Pending")
+        .def("result", &Pending::result, "응답을 기다려 [(x, y, w, h, cls), ...] 반환")
+        .def("done", &Pending::done)
+        .def_property_readonly("jpeg", &Pending::jpeg)
+        .def_property_readonly("frame", [](Pending& p) { return p.f.get().frame; })
+        .def_property_readonly("rtt_ms", [](Pending& p) { return p.f.get().rtt_ms; });
+
+    py::class_<drawc::Client>(m, "Client")
+        .def(py::init([](const std::string& host, int port, std::map<std::string, std::string> stream,
+                         int depth, int quality, std::pair<int, int> frame_size) {
+                 drawc::Options o;
+                 o.host = host; o.port = port; o.stream = std::move(stream);
+                 o.depth = depth; o.jpeg_quality = quality;
+                 o.frame_size = cv::Size(frame_size.first, frame_size.second);
+                 return std::make_unique<drawc::Client>(o);
+             }),
+             py::arg("host"), py::arg("port"), py::arg("stream") = std::map<std::string, std::string>{},
+             py::arg("depth") = 4, py::arg("quality") = 80, py::arg("frame_size") = std::pair<int, int>{0, 0})
+        .def("submit", [](drawc::Client& c, py::array_t<uint8_t, py::array::c_style | py::array::forcecast> img) {
+                 if (img.ndim() != 3 || img.shape(2) != 3) throw py::value_error("expected HxWx3 uint8 BGR array");
+                 cv::Mat mat((int)img.shape(0), (int)img.shape(1), CV_8UC3, (void*)img.data());   // 복사 없음
+                 py::gil_scoped_release nogil;
+                 return Pending{c.submit(mat).share()};
+             })
+        .def("submit_jpeg", [](drawc::Client& c, py::bytes jpg) {
+                 char* p; Py_ssize_t n;
+                 PyBytes_AsStringAndSize(jpg.ptr(), &p, &n);
+                 py::gil_scoped_release nogil;
+                 return Pending{c.submitJpeg((const uint8_t*)p, (size_t)n).share()};
+             })
+        .def_property_readonly("ack", &drawc::Client::ack)
+        .def_property_readonly("fit", [](drawc::Client& c) { return std::make_pair(c.fit().width, c.fit().height); })
+        .def_property_readonly("in_flight", &drawc::Client::inFlight)
+        .def("close", &drawc::Client::close, py::call_guard<py::gil_scoped_release>());
+}
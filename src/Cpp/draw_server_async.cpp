@@ -10,6 +10,9 @@
 
 #include <algorithm>
 #include <numeric>
+#include <memory>
+
+#include "fast_log.hpp"
 
 #define PORT 9888
 
@@ -44,8 +47,19 @@ private:
     int input_h;
     int input_w;
 
+    // 한 번만 만들어 매 프레임 재사용 (이름 배열·MemoryInfo·입출력 버퍼·바인딩)
+    Ort::MemoryInfo memory_info;
+    std::vector<const char*> input_names_c_str;
+    std::vector<const char*> output_names_c_str;
+    std::vector<float> input_buf;
+    std::vector<float> output_buf;
+    Ort::Value input_tensor{nullptr};
+    Ort::Value output_tensor{nullptr};
+    std::unique_ptr<Ort::IoBinding> binding;
+
 public:
-    InferenceHelper() : env(ORT_LOGGING_LEVEL_WARNING, "ONNX_SERVER"), session(nullptr) {
+    InferenceHelper() : env(ORT_LOGGING_LEVEL_WARNING, "ONNX_SERVER"), session(nullptr),
+                        memory_info(Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault)) {
         Ort::SessionOptions session_options;
         session_options.SetIntraOpNumThreads(1);
 
@@ -87,6 +101,18 @@ public:
         input_h = input_dims[2];
         input_w = input_dims[3];
 
+        // 입력·출력 텐서를 미리 할당한 버퍼에 한 번만 바인딩
+        for (const auto& name : input_names_str) input_names_c_str.push_back(name.c_str());
+        for (const auto& name : output_names_str) output_names_c_str.push_back(name.c_str());
+
+        input_buf.resize(3 * input_h * input_w);
+        output_buf.resize(output_dims[1] * output_dims[2]);
+        input_tensor = Ort::Value::CreateTensor<float>(memory_info, input_buf.data(), input_buf.size(), input_dims.data(), input_dims.size());
+        output_tensor = Ort::Value::CreateTensor<float>(memory_info, output_buf.data(), output_buf.size(), output_dims.data(), output_dims.size());
+        binding = std::make_unique<Ort::IoBinding>(session);
+        binding->BindInput(input_names_c_str[0], input_tensor);
+        binding->BindOutput(output_names_c_str[0], output_tensor);
+
         std::cout << "ONNX 모델 로드 완료: " << MODEL_PATH << std::endl;
         std::cout << "입력 차원 (NCHW): " << input_dims[0] << "x" << input_dims[1] << "x" << input_dims[2] << "x" << input_dims[3] << std::endl;
 
@@ -96,31 +122,17 @@ public:
     std::string run_inference(const cv::Mat& original_image) {
         cv::Mat processed_image;
         float scale;
-        cv::Mat preprocessed_blob = preprocess(original_image, processed_image, scale);
-
-        Ort::MemoryInfo memory_info = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
-        Ort::Value input_tensor = Ort::Value::CreateTensor<float>(memory_info, preprocessed_blob.ptr<float>(), preprocessed_blob.total(), input_dims.data(), input_dims.size());
-        
-        // input_names와 output_names를 const char* 배열로 변환
-        std::vector<const char*> input_names_c_str;
-        for (const auto& name : input_names_str) {
-            input_names_c_str.push_back(name.c_str());
-        }
+        preprocess(original_image, processed_image, scale);   // input_buf 에 직접 기록
 
-        std::vector<const char*> output_names_c_str;
-        for (const auto& name : output_names_str) {
-            output_names_c_str.push_back(name.c_str());
-        }
+        // 바인딩된 버퍼로 추론 (출력은 output_buf 에 기록됨)
+        session.Run(Ort::RunOptions{nullptr}, *binding);
 
-        // Run 함수 호출 시 변환된 const char* 배열 사용
-        auto output_tensors = session.Run(Ort::RunOptions{nullptr}, input_names_c_str.data(), &input_tensor, 1, output_names_c_str.data(), 1);
-
-        return postprocess(output_tensors[0], scale, original_image.size());
+        return postprocess(scale, original_image.size());
     }
 
 private:
-    // 전처리 함수
-    cv::Mat preprocess(const cv::Mat& image, cv::Mat& out_image, float& out_scale) {
+    // 전처리 함수 (결과는 CHW 로 input_buf 에 기록)
+    void preprocess(const cv::Mat& image, cv::Mat& out_image, float& out_scale) {
         // 레터박싱으로 비율을 유지하며 리사이즈
         float r = std::min((float)input_w / image.cols, (float)input_h / image.rows);
         out_scale = r;
@@ -141,29 +153,34 @@ private:
         cv::cvtColor(out_image, blob, cv::COLOR_BGR2RGB);
         blob.convertTo(blob, CV_32F, 1.0/255.0);
 
-        // HWC to CHW
-        return cv::dnn::blobFromImage(blob);
+        // HWC to CHW: input_buf 의 각 채널 평면에 바로 split
+        std::vector<cv::Mat> planes;
+        for (int c = 0; c < 3; ++c) {
+            planes.emplace_back(input_h, input_w, CV_32F, input_buf.data() + c * input_h * input_w);
+        }
+        cv::split(blob, planes);
     }
 
     // 후처리 함수
-    std::string postprocess(Ort::Value& output_tensor, float scale, const cv::Size& original_img_size) {
-        float* raw_output = output_tensor.GetTensorMutableData<float>();
+    std::string postprocess(float scale, const cv::Size& original_img_size) {
+        const float* raw_output = output_buf.data();
         
         std::vector<cv::Rect> boxes;
         std::vector<float> confidences;
 
         // YOLOv8 출력 형식 [1, 84, 8400]을 가정 (x_center, y_center, w, h, class_probs...)
         // 모델에 따라 이 부분의 구조가 달라질 수 있습니다.
-        cv::Mat output_mat(output_dims[1], output_dims[2], CV_32F, raw_output);
-        output_mat = output_mat.t(); // Transpose to [8400, 84]
+        // 전치 복사 없이 출력 버퍼를 [채널][앵커] 순서 그대로 읽는다.
+        const int num_anchors = static_cast<int>(output_dims[2]);
+        auto at = [&](int i, int c) { return raw_output[c * num_anchors + i]; };
 
-        for (int i = 0; i < output_mat.rows; i++) {
-            float confidence = output_mat.at<float>(i, 4); // 예시: 5번째 값이 전체 confidence
+        for (int i = 0; i < num_anchors; i++) {
+            float confidence = at(i, 4); // 예시: 5번째 값이 전체 confidence
             if (confidence > CONFIDENCE_THRESHOLD) {
-                float cx = output_mat.at<float>(i, 0);
-                float cy = output_mat.at<float>(i, 1);
-                float w = output_mat.at<float>(i, 2);
-                float h = output_mat.at<float>(i, 3);
+                float cx = at(i, 0);
+                float cy = at(i, 1);
+                float w = at(i, 2);
+                float h = at(i, 3);
 
                 // 좌표 스케일링
                 int left = static_cast<int>((cx - w / 2 - (input_w - original_img_size.width * scale) / 2) / scale);
@@ -264,7 +281,7 @@ int main() {
         std::string bounding_boxes_str = inference_helper.run_inference(image);
 
         send(new_socket, bounding_boxes_str.c_str(), bounding_boxes_str.length(), 0);
-        std::cout << "결과 전송: " << bounding_boxes_str << std::endl;
+        FLOG_EVERY_MS(FLOG_LV_INFO, 1000, "결과 전송: {}", bounding_boxes_str);  // 매 프레임 찍으면 핫 패스가 된다
     }
 
     close(new_socket);
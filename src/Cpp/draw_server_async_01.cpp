@@ -1,142 +1,988 @@
 // draw_server_async_fixed.cpp
-// 빌드: g++ -std=c++17 draw_server_async_fixed.cpp `pkg-config --cflags --libs opencv4` -lonnxruntime -lpthread -o server
-// 실행: ./server 0.0.0.0 9888 yolov8n.onnx
+// 빌드: g++ -std=c++20 draw_server_async_fixed.cpp `pkg-config --cflags --libs opencv4` -lonnxruntime -lpthread -o server  (lz4 가 있으면 -llz4 추가)
+// 실행: ./server 0.0.0.0 9888 yolov8n.onnx [추론 워커 수]
+//       ./server --batch yolov8n.onnx clip.mp4 frames_dir/ --out=results.jsonl [--batch-size=8]  (오프라인 배치)
 #include <iostream>
 #include <vector>
 #include <string>
 #include <sstream>
 #include <cstring>
+#include <cmath>
+#include <cctype>
+#include <map>
+#include <tuple>
+#include <deque>
+#include <atomic>
+#include <functional>
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <thread>
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <optional>
 #include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <csignal>
 #include <arpa/inet.h>
+#include <endian.h>
 #include <opencv2/opencv.hpp>
 #include <onnxruntime_cxx_api.h>
+#include "result_cache.hpp"
+#include "mjpeg_hub.hpp"
+#include "det_log.hpp"
+#include "fast_log.hpp"
+#include "numa_topo.hpp"
+#include "co_loop.hpp"
+#include "frame_trace.hpp"
+#include "huge_alloc.hpp"
+#include "udp_frames.hpp"
+#include "det_delta.hpp"
+#include "infer_core.hpp"      // 모델 형태 · 전처리 · 후처리
+#include "infer_sched.hpp"     // 스케줄러 · 추론 워커 · 도메인
+#include "batch_run.hpp"       // --batch
+#include "verify_run.hpp"      // --verify
+#include "proc_super.hpp"      // --procs
 
-constexpr int   INPUT_W = 640, INPUT_H = 640;
-constexpr int   NUM_CLASSES = 80;
-//constexpr float CONF_THR = 0.35f, NMS_THR = 0.45f;
-constexpr float CONF_THR = 0.35f, NMS_THR = 0.45f;
+constexpr size_t CACHE_ENTRIES = 256;             // 동일 프레임 결과 캐시 크기
+constexpr int    RENDER_THREADS = 2;              // 서버측 그리기·JPEG 인코딩 스레드
+constexpr size_t RENDER_QUEUE   = 8;              // 밀리면 MJPEG 프레임은 버린다
+constexpr int    RENDER_QUALITY = 80;
+constexpr int    CASCADE_IMGSZ   = 320;           // cascade: 예비 패스 해상도
+constexpr float  CASCADE_CONF    = 0.5f;          // 예비 패스 점수 컷 = 스트림 컷 × 이 값 (후보를 놓치지 않게)
+constexpr int    CASCADE_REFRESH = 30;            // N 프레임마다 전체 해상도 패스
+constexpr int    CASCADE_CROPS   = 4;             // 후보 영역이 이보다 많으면 전체 패스
+constexpr int    CASCADE_CROP    = 320;           // 후보 주변 자르기 최소 한 변 (원본 픽셀)
+constexpr size_t TRACE_SLOTS      = 65536;        // --trace: 스레드당 구간 링 크기
+constexpr int    TRACE_WINDOW_SEC = 10;           // 덤프할 최근 구간 (초)
 
-/* ───── 전처리 (호출자 소유 blob) ───────────────────────────────────────── */
-Ort::Value preprocess(const cv::Mat& src,
-                      std::vector<float>& blob,
-                      float& scale,
-                      Ort::MemoryInfo& mem)
+/* ───── TCP 헬퍼 ──────────────────────────────────────────────────────── */
+
+/* ───── 스트림 설정 (핸드셰이크) ─────────────────────────────────────────
+ * 첫 4바이트가 HELLO_MAGIC 이면 [u32 길이][key=value ...] 텍스트가 뒤따르고,
+ * 서버는 "ok ...\n" 한 줄로 응답한다. 그 외에는 구버전 클라이언트로 보고
+ * 첫 4바이트를 바로 프레임 길이로 해석한다.                                  */
+constexpr uint32_t HELLO_MAGIC = 0x44525731;   // "DRW1"
+constexpr uint32_t MAX_HELLO   = 4096;
+
+enum class Render { None, Jpeg, Mjpeg };      // jpeg = 응답 뒤에 그린 프레임, mjpeg = HTTP 로 송출
+
+struct StreamCfg {
+    int       priority    = 1;        // 핸드셰이크 없는 클라이언트는 중간 tier
+    int       deadline_ms = 0;        // 0 = 데드라인 없음
+    int       imgsz       = INPUT_W;  // 해상도 프로파일 (긴 변, 동적 입력 모델에서만 의미)
+    cv::Rect  roi;                    // 비어 있으면 전체 프레임
+    FilterPtr filter = std::make_shared<ClassFilter>();
+    std::string sig;                  // 결과에 영향을 주는 설정의 정규화 문자열
+    Render    render = Render::None;
+    std::string name;                 // MJPEG 스트림 이름 (/name)
+    bool      cascade = false;        // 저해상도 예비 패스 → 후보 주변만 정밀 패스
+    FilterPtr pre_filter;             // 예비 패스용 (점수 컷을 낮춘 filter)
+    bool      ts = false;             // 프레임 헤더에 클라이언트 시각 [u64 촬영 μs][u64 송신 μs]
+    uint32_t  track = 0;              // 트레이스 트랙 (--trace 일 때 연결마다)
+    cv::Size  fit;                    // 클라이언트가 줄여 보낼 프레임 크기 (frame=WxH 를 보냈을 때)
+    float     fit_scale = 1.f;        // fit / 원본
+    bool      delta = false;          // enc=delta : 결과를 [u32 길이][직전 대비 델타] 로 (det_delta.hpp)
+    int       keyframe = ddelta::KEYFRAME;   // 델타 모드에서 전체 목록을 다시 보내는 간격 (프레임)
+};
+
+std::vector<std::string> splitList(const std::string& s, char sep)
+{
+    std::vector<std::string> out; std::string item; std::istringstream is(s);
+    while(std::getline(is,item,sep)) if(!item.empty()) out.push_back(item);
+    return out;
+}
+
+// classes=0,2,5  conf=0.4 | conf=0:0.5,2:0.3  (클래스 미지정 = 전체)
+FilterPtr parseFilter(const std::string& classes, const std::string& conf)
+{
+    auto f=std::make_shared<ClassFilter>();
+    if(!classes.empty()){
+        f->ids.clear();
+        for(auto& c: splitList(classes,',')){
+            int id=std::stoi(c);
+            if(id>=0 && id<NUM_CLASSES) f->ids.push_back(id);
+        }
+    }
+    for(auto& item: splitList(conf,',')){
+        auto colon=item.find(':');
+        if(colon==std::string::npos) std::fill(f->thr.begin(),f->thr.end(),std::stof(item));
+        else{
+            int id=std::stoi(item.substr(0,colon));
+            if(id>=0 && id<NUM_CLASSES) f->thr[id]=std::stof(item.substr(colon+1));
+        }
+    }
+    f->min_thr=1.f;
+    for(int c: f->ids) f->min_thr=std::min(f->min_thr,f->thr[c]);
+    return f;
+}
+
+std::map<std::string,std::string> parseKV(const std::string& txt)
+{
+    std::map<std::string,std::string> kv;
+    std::istringstream is(txt); std::string tok;
+    while(is>>tok){
+        auto eq=tok.find('=');
+        if(eq==std::string::npos) kv[tok]="1";
+        else kv[tok.substr(0,eq)]=tok.substr(eq+1);
+    }
+    return kv;
+}
+
+// 결과 캐시 키의 seed: 모델과, 결과에 영향을 주는 스트림 설정
+uint64_t cacheSeed(const StreamCfg& cfg)
+{
+    return model_id ^ contentHash(cfg.sig.data(), cfg.sig.size());
+}
+
+// 핸드셰이크 텍스트 → cfg, 돌려보낼 "ok ..." 줄은 ack 에
+// 클라이언트 프레임 크기 → 줄여 보낼 크기. ROI(또는 전체)가 모델 입력에 딱 맞도록 줄이고, 키우지는 않는다.
+cv::Size fitSize(const cv::Size& frame, const cv::Rect& roi, int imgsz, float& s)
+{
+    cv::Rect r = roi.empty() ? cv::Rect(0,0,frame.width,frame.height) : roi & cv::Rect(0,0,frame.width,frame.height);
+    s = 1.f;
+    if(r.empty()) return {};
+    cv::Size in = inputShape(r.size(), imgsz);
+    s = std::min(1.f, std::min(in.width/(float)r.width, in.height/(float)r.height));
+    if(s>=1.f) return {};
+    return { (int)std::lround(frame.width*s), (int)std::lround(frame.height*s) };
+}
+
+bool applyHello(const std::string& txt, StreamCfg& cfg, std::string& ack)
 {
-    int w = src.cols, h = src.rows;
-    scale = std::min(INPUT_W/(float)w, INPUT_H/(float)h);
-    int nw = int(w * scale), nh = int(h * scale);
+    auto kv=parseKV(txt);
+    try{
+        if(kv.count("priority"))    cfg.priority    = std::stoi(kv["priority"]);
+        if(kv.count("deadline_ms")) cfg.deadline_ms = std::stoi(kv["deadline_ms"]);
+        if(kv.count("imgsz"))       cfg.imgsz       = std::stoi(kv["imgsz"]);
+        if(kv.count("roi")){
+            auto v=splitList(kv["roi"],',');
+            if(v.size()!=4) return false;
+            cfg.roi=cv::Rect(std::stoi(v[0]),std::stoi(v[1]),std::stoi(v[2]),std::stoi(v[3]));
+        }
+        if(kv.count("classes") || kv.count("conf"))
+            cfg.filter=parseFilter(kv["classes"],kv["conf"]);
+        if(kv.count("render")){
+            if(kv["render"]=="jpeg")       cfg.render=Render::Jpeg;
+            else if(kv["render"]=="mjpeg") cfg.render=Render::Mjpeg;
+            else return false;
+        }
+        if(kv.count("cascade")) cfg.cascade = kv["cascade"]!="0";
+        if(kv.count("ts"))      cfg.ts      = kv["ts"]!="0";
+        if(kv.count("frame")){                            // frame=1920x1080 → ack 에 fit=WxH
+            auto x=kv["frame"].find('x'); if(x==std::string::npos) return false;
+            cv::Size fs(std::stoi(kv["frame"].substr(0,x)), std::stoi(kv["frame"].substr(x+1)));
+            if(fs.width<=0 || fs.height<=0) return false;
+            cfg.fit=fs;                                   // 아래에서 fitSize 로 바꾼다
+        }
+        if(kv.count("enc")){
+            if(kv["enc"]=="delta")     cfg.delta=true;
+            else if(kv["enc"]!="text") return false;
+        }
+        if(kv.count("keyframe")) cfg.keyframe = std::max(1, std::stoi(kv["keyframe"]));
+        if(kv.count("name")){
+            cfg.name=kv["name"];                          // 파일·URL 이름으로도 쓰이므로 정리
+            for(char& ch: cfg.name) if(!std::isalnum((unsigned char)ch) && ch!='-' && ch!='_') ch='_';
+        }
+    }catch(const std::exception&){ return false; }
+    cfg.priority    = std::max(0, std::min(NUM_TIERS-1, cfg.priority));
+    cfg.deadline_ms = std::max(0, cfg.deadline_ms);
+    cfg.imgsz       = std::max(MIN_IMGSZ, std::min(INPUT_W, cfg.imgsz/STRIDE*STRIDE));
+    cfg.sig         = "imgsz="+std::to_string(cfg.imgsz)+" roi="+kv["roi"]
+                    + " classes="+kv["classes"]+" conf="+kv["conf"];
+    if(cfg.cascade && !dyn_input) cfg.cascade=false;    // 고정 입력 모델은 예비 패스도 640 이라 이득 없음
+    if(cfg.cascade){
+        auto pf=std::make_shared<ClassFilter>(*cfg.filter);
+        for(float& t: pf->thr) t*=CASCADE_CONF;
+        pf->min_thr*=CASCADE_CONF;
+        cfg.pre_filter=pf;
+        cfg.sig+=" cascade";
+    }
+    // cascade 는 후보 주변을 원본 해상도로 다시 보므로 줄여 받지 않는다
+    cfg.fit = cfg.fit.empty() || cfg.cascade ? cv::Size() : fitSize(cfg.fit,cfg.roi,cfg.imgsz,cfg.fit_scale);
+    if(cfg.fit.empty()) cfg.fit_scale=1.f;
+    if(!cfg.fit.empty()){                                // fit 크기로 온 프레임은 ROI·결과를 fit_scale 로 되돌리므로
+        char fs[64];                                     // 같은 JPEG 라도 fit 이 다르면 결과가 다르다 (캐시 키에 포함)
+        std::snprintf(fs,sizeof(fs)," fit=%dx%d fit_scale=%a",cfg.fit.width,cfg.fit.height,(double)cfg.fit_scale);
+        cfg.sig+=fs;
+    }
 
-    cv::Mat resized;  cv::resize(src, resized, {nw, nh});
-    cv::Mat canvas(INPUT_H, INPUT_W, CV_8UC3, cv::Scalar(114,114,114));
-    resized.copyTo(canvas(cv::Rect(0,0,nw,nh)));
+    std::ostringstream os;
+    os<<"ok priority="<<cfg.priority<<" deadline_ms="<<cfg.deadline_ms
+      <<" imgsz="<<(dyn_input ? cfg.imgsz : std::max(model_in.width, model_in.height));
+    if(kv.count("cascade")) os<<" cascade="<<(cfg.cascade ? 1 : 0);
+    if(kv.count("ts"))      os<<" ts="<<(cfg.ts ? 1 : 0);
+    if(kv.count("frame"))   os<<" fit="<<cfg.fit.width<<'x'<<cfg.fit.height;   // 0x0 = 줄이지 말 것
+    if(cfg.delta)           os<<" enc=delta keyframe="<<cfg.keyframe;
+    os<<'\n';
+    ack=os.str();
+    return true;
+}
 
-    cv::cvtColor(canvas, canvas, cv::COLOR_BGR2RGB);
-    canvas.convertTo(canvas, CV_32F, 1.0/255.0);
+// 원본 좌표 결과를 줄여 받은 프레임 위에 그릴 때
+std::vector<Det> scaleDets(std::vector<Det> dets, float s)
+{
+    for(auto& d: dets)
+        d.box=cv::Rect((int)std::lround(d.box.x*s),(int)std::lround(d.box.y*s),
+                       (int)std::lround(d.box.width*s),(int)std::lround(d.box.height*s));
+    return dets;
+}
 
-    std::vector<cv::Mat> ch(3); cv::split(canvas, ch);
-    for (int i = 0; i < 3; ++i)
-        std::memcpy(blob.data()+i*INPUT_H*INPUT_W, ch[i].data, INPUT_H*INPUT_W*sizeof(float));
+MjpegHub::Jpeg renderJpeg(cv::Mat frame, const std::vector<Det>& dets)
+{
+    drawDetections(frame,dets);
+    auto jpg=std::make_shared<std::vector<uchar>>();
+    cv::imencode(".jpg",frame,*jpg,{cv::IMWRITE_JPEG_QUALITY,RENDER_QUALITY});
+    return jpg;
+}
+
+// 작업을 스케줄러에 넣고, 워커가 결과를 내면 루프 스레드에서 코루틴을 재개한다
+auto inferAsync(co::EventLoop& loop, Scheduler& sched, JobPtr job)
+{
+    struct Await {
+        co::EventLoop& loop; Scheduler& sched; JobPtr job; std::future<Result> fut;
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> h){
+            fut=job->result.get_future();
+            job->done=[this,h]{ loop.post(h); };
+            sched.submit(job);
+        }
+        Result await_resume(){ return fut.get(); }
+    };
+    return Await{loop,sched,std::move(job),{}};
+}
+
+// 여러 작업을 한꺼번에 넣고 (같은 형태면 워커가 배치로 묶음) 모두 끝나면 재개
+auto inferAll(co::EventLoop& loop, Scheduler& sched, const std::vector<JobPtr>& jobs)
+{
+    struct Await {
+        co::EventLoop& loop; Scheduler& sched; const std::vector<JobPtr>& jobs;
+        std::vector<std::future<Result>> futs; std::atomic<size_t> left{0};
+        bool await_ready() const noexcept { return jobs.empty(); }
+        void await_suspend(std::coroutine_handle<> h){
+            left=jobs.size();
+            for(auto& j: jobs){
+                futs.push_back(j->result.get_future());
+                j->done=[this,h]{ if(--left==0) loop.post(h); };
+            }
+            for(auto& j: jobs) sched.submit(j);
+        }
+        std::vector<Result> await_resume(){
+            std::vector<Result> rs;
+            for(auto& f: futs) rs.push_back(f.get());
+            return rs;
+        }
+    };
+    return Await{loop,sched,jobs};
+}
 
-    std::vector<int64_t> dims{1,3,INPUT_H,INPUT_W};
-    return Ort::Value::CreateTensor<float>(mem, blob.data(), blob.size(), dims.data(), dims.size());
+/* ───── cascade: 저해상도 예비 패스 → 후보 주변만 정밀 패스 ─────────────────
+ * 예비 패스(320, 낮춘 점수 컷)에서 아무것도 없으면 그 결과로 끝 (빈 장면은 1/4 비용).
+ * 후보가 있으면 주변을 원본 해상도로 잘라 한꺼번에 추론하고 합친다.
+ * CASCADE_REFRESH 프레임마다, 또는 후보 영역이 많으면 전체 프레임 패스.          */
+std::vector<cv::Rect> cascadeCrops(const std::vector<Det>& cands, cv::Point off, const cv::Size& img)
+{
+    std::vector<cv::Rect> crops;
+    for(const auto& d: cands){                          // 후보 박스의 2배, 최소 CASCADE_CROP 정사각
+        int side=std::max(CASCADE_CROP, 2*std::max(d.box.width,d.box.height));
+        cv::Point c=(d.box.tl()+d.box.br())/2-off;
+        crops.emplace_back(c.x-side/2, c.y-side/2, side, side);
+    }
+    for(bool merged=true; merged; ){                    // 겹치는 영역은 합친다
+        merged=false;
+        for(size_t i=0;i<crops.size() && !merged;++i)
+            for(size_t j=i+1;j<crops.size();++j)
+                if((crops[i]&crops[j]).area()>0){ crops[i]|=crops[j]; crops.erase(crops.begin()+j); merged=true; break; }
+    }
+    for(auto& r: crops) r&=cv::Rect(0,0,img.width,img.height);
+    crops.erase(std::remove_if(crops.begin(),crops.end(),[](const cv::Rect& r){ return r.empty(); }),crops.end());
+    return crops;
 }
 
-/* ───── 후처리 (NMS + 클래스라벨) ─────────────────────────────────────── */
-std::string postprocess(const Ort::Value& out,
-                        float scale, const cv::Size&)
+co::Task<Result> inferCascade(co::EventLoop& loop, Scheduler& sched, const StreamCfg& cfg, cv::Mat img,
+                              cv::Point off, uint64_t frame_no, uint64_t frame_id,
+                              Clock::time_point deadline, bool& cacheable)
 {
-    const float* p = out.GetTensorData<float>();
-    auto shp = out.GetTensorTypeAndShapeInfo().GetShape();   // [1,84,8400]
-    int N = (int)shp[2];
+    auto make=[&](const cv::Mat& m, cv::Point o, int imgsz, const FilterPtr& f){
+        auto j=std::make_shared<Job>();
+        j->tier=cfg.priority; j->frame_no=frame_no; j->imgsz=imgsz;
+        j->img=m; j->off=o; j->filter=f; j->deadline=deadline;
+        j->track=cfg.track; j->trace_frame=frame_id;
+        return j;
+    };
+
+    auto pre=make(img,off,CASCADE_IMGSZ,cfg.pre_filter);
+    Result pr=co_await inferAsync(loop,sched,pre);
+    const bool refresh = frame_no%CASCADE_REFRESH==0;
+    if(pr.dets.empty() && !refresh){ cacheable=pre->cacheable; co_return pr; }
+
+    std::vector<cv::Rect> crops;
+    if(!refresh) crops=cascadeCrops(pr.dets,off,img.size());
+    if(refresh || crops.empty() || (int)crops.size()>CASCADE_CROPS){
+        auto full=make(img,off,cfg.imgsz,cfg.filter);
+        Result r=co_await inferAsync(loop,sched,full);
+        cacheable=full->cacheable;
+        co_return r;
+    }
+
+    std::vector<JobPtr> jobs;
+    for(const auto& r: crops){                          // 원본 해상도 그대로 (긴 변 640 까지)
+        int side=std::max(r.width,r.height);
+        int imgsz=std::max(MIN_IMGSZ, std::min(cfg.imgsz, (side+STRIDE-1)/STRIDE*STRIDE));
+        jobs.push_back(make(img(r),off+r.tl(),imgsz,cfg.filter));
+    }
+    auto parts=co_await inferAll(loop,sched,jobs);
 
+    // 영역 경계에 걸친 중복은 NMS 로 정리
     std::vector<cv::Rect> boxes; std::vector<float> scores; std::vector<int> cls;
-    auto sig = [](float x){ return 1.f / (1.f + std::exp(-x)); };
-    for (int i = 0; i < N; ++i) {
-        
-        float obj = sig(p[4*N + i]);
-        if (obj < CONF_THR) continue;
-
-        /* ── 클래스 선택 ────────────────────── */
-        float best_cls = 0.f; int best_id = -1;
-        for (int c = 0; c < NUM_CLASSES; ++c) {
-            float cls = sig(p[(5 + c)*N + i]);
-            if (cls > best_cls) { best_cls = cls; best_id = c; }
-        }
-
-        float conf = obj * best_cls;
-        if (conf < CONF_THR) continue;              // ① 점수 컷
-
-        /* ── BBox 좌표 복원 ─────────────────── */
-        float cx = p[0*N + i], cy = p[1*N + i];
-        float bw = p[2*N + i], bh = p[3*N + i];
-        float x1 = (cx - bw/2.f) / scale;
-        float y1 = (cy - bh/2.f) / scale;
-
-        /* ── ② 면적 필터 ────────────────────── */
-        float area = (bw * bh) / (INPUT_W * INPUT_H);   // 상대 면적 (0~1)
-        if (area < 0.0005f) // 0.05 % 미만은 스킵
-            continue;
-
-        /* ── 통과 ⇒ push_back ──────────────── */
-        boxes.emplace_back(cv::Rect(round(x1), round(y1), round(bw/scale), round(bh/scale)));
-        scores.emplace_back(conf);
-        cls.emplace_back(best_id);
-
-        // float obj = sig(p[4*N + i]);
-        // //float obj = p[4*N + i];
-        
-        // if (obj < CONF_THR) continue;
-        // float best = 0.f; int best_id = -1;
-        // for (int c = 0; c < NUM_CLASSES; ++c) {
-
-        //     float v = sig(p[(5 + c)*N + i]);
-        //     //float v = p[(5 + c)*N + i];
-        //     if (v > best) { best = v; best_id = c; }
-        // }
-        // float conf = obj * best; if (conf < CONF_THR) continue;
-
-        // float cx=p[0*N+i], cy=p[1*N+i], w=p[2*N+i], h=p[3*N+i];
-        // float x1=(cx-w/2)/scale, y1=(cy-h/2)/scale;
-        // boxes.emplace_back(cv::Rect(round(x1),round(y1),round(w/scale),round(h/scale)));
-        // scores.push_back(conf); cls.push_back(best_id);
-        // NMS 전, 상위 20개 로그 출력 (디버깅용)
-        //if (i < 20)
-            std::cout << "pred " << i << " cls=" << best_id << " conf=" << conf << '\n';
-    }
-    std::vector<int> keep; cv::dnn::NMSBoxes(boxes,scores,CONF_THR,NMS_THR,keep);
-
-    std::ostringstream ss; ss<<'[';
-    for(size_t k=0;k<keep.size();++k){
-        int i=keep[k]; const auto& r=boxes[i];
-        ss<<r.x<<','<<r.y<<','<<r.width<<','<<r.height<<','<<cls[i];
-        if(k+1<keep.size()) ss<<',';
-    }
-    ss<<']'; return ss.str();
+    cacheable=true;
+    for(size_t k=0;k<parts.size();++k){
+        cacheable = cacheable && jobs[k]->cacheable;
+        for(const auto& d: parts[k].dets){ boxes.push_back(d.box); scores.push_back(d.score); cls.push_back(d.cls); }
+    }
+    std::vector<int> keep; cv::dnn::NMSBoxes(boxes,scores,cfg.filter->min_thr,NMS_THR,keep);
+    Result res;
+    for(int i: keep) res.dets.push_back({boxes[i],cls[i],scores[i]});
+    res.text=serialize(res.dets);
+    co_return res;
 }
 
-/* ───── TCP 헬퍼 ──────────────────────────────────────────────────────── */
-bool recvAll(int s, void* b, size_t l){char* p=(char*)b;while(l){ssize_t n=recv(s,p,l,0);if(n<=0)return false;p+=n;l-=n;}return true;}
-bool sendAll(int s,const void* b,size_t l){const char* p=(const char*)b;while(l){ssize_t n=send(s,p,l,0);if(n<=0)return false;p+=n;l-=n;}return true;}
+/* ───── 연결 스레드들이 공유하는 서버 상태 ────────────────────────────── */
+struct ServerCtx {
+    std::vector<std::unique_ptr<Domain>> domains;
+    ResultCache<Result> cache{CACHE_ENTRIES};
+    TaskPool            render{RENDER_THREADS,[]{ ftrace::nameThread("render"); }};
+    MjpegHub            mjpeg;
+    std::unique_ptr<DetLogWriter> detlog;        // --detlog=DIR 일 때만
+    std::atomic<int>    conn_seq{0};
+    std::atomic<int>    active{0};               // 처리 중인 TCP 연결 + 추론 중인 UDP 스트림 (종료 시 대기용)
+    std::atomic<bool>   stopping{false};         // 종료 중: UDP 수신 스레드가 새 프레임을 루프로 넘기지 않는다
+    std::string         name_prefix="s";         // 이름 없는 스트림: <prefix><순번>
+
+    Domain& pick(){                              // 연결 수가 가장 적은 도메인
+        Domain* best=domains[0].get();
+        for(auto& d: domains) if(d->conns<best->conns) best=d.get();
+        return *best;
+    }
+};
+
+/* ───── 프레임 1장 (TCP·UDP 공용): 캐시 조회 → 디코드 → ROI → 추론 ────────────
+ * 그리기에 쓸 디코드 프레임은 frame 에 (캐시 적중이면 render 일 때만 디코드).
+ * ROI 가 프레임 밖이라 추론할 것이 없으면 nullopt (빈 결과로 응답).           */
+co::Task<std::optional<Result>> inferFrame(ServerCtx& ctx, Domain& dom, const StreamCfg& cfg, uint64_t seed,
+                                           const uchar* data, size_t n, uint64_t& frame_no, uint64_t frame_id,
+                                           Clock::time_point arrived, cv::Mat& frame, bool& hit)
+{
+    co::EventLoop& loop=*dom.loop;
+    Result res;
+    const uint64_t key=contentHash(data,n,seed);
+    hit=ctx.cache.get(key,res);
+
+    if(!hit || cfg.render!=Render::None)                 // 캐시 적중이어도 그리려면 디코드 필요
+        frame = co_await loop.offload(*dom.cpu,[&]{
+            ftrace::Scope ts("imdecode",cfg.track,frame_id);
+            return cv::imdecode(cv::Mat(1,(int)n,CV_8U,(void*)data),cv::IMREAD_COLOR);
+        });
+    if(hit) co_return res;
+
+    cv::Mat img=frame; cv::Point off;
+    // fit 크기로 온 프레임: ROI 를 줄인 좌표로 자르고, 결과는 워커가 원본 좌표로 되돌린다
+    const float pre = !cfg.fit.empty() && frame.size()==cfg.fit ? cfg.fit_scale : 1.f;
+    if(!cfg.roi.empty() && !img.empty()){              // 전처리 전에 ROI 로 자르기 (복사 없음)
+        cv::Rect ro=cfg.roi, r=ro;                      // ro: 원본 좌표, r: 받은 프레임 좌표
+        if(pre<1.f){
+            ro&=cv::Rect(0,0,(int)std::lround(img.cols/pre),(int)std::lround(img.rows/pre));
+            r=cv::Rect((int)std::lround(ro.x*pre),(int)std::lround(ro.y*pre),
+                       (int)std::lround(ro.width*pre),(int)std::lround(ro.height*pre));
+        }
+        r&=cv::Rect(0,0,img.cols,img.rows);
+        img = r.empty() ? cv::Mat() : img(r);
+        off = pre<1.f ? ro.tl() : r.tl();
+    }
+    if(img.empty()) co_return std::nullopt;
+
+    const auto deadline = cfg.deadline_ms>0 ? arrived+std::chrono::milliseconds(cfg.deadline_ms)
+                                            : Clock::time_point::max();
+    bool cacheable=false;
+    if(cfg.cascade)
+        res = co_await inferCascade(loop,dom.sched,cfg,img,off,frame_no++,frame_id,deadline,cacheable);
+    else{
+        auto job=std::make_shared<Job>();
+        job->tier=cfg.priority; job->frame_no=frame_no++; job->imgsz=cfg.imgsz;
+        job->img=std::move(img); job->off=off; job->filter=cfg.filter; job->deadline=deadline;
+        job->pre_scale=pre;
+        job->track=cfg.track; job->trace_frame=frame_id;
+        res = co_await inferAsync(loop,dom.sched,job);
+        cacheable=job->cacheable;
+    }
+    if(cacheable) ctx.cache.put(key,res);
+    co_return res;
+}
+
+/* ───── 클라이언트 1개 처리 (코루틴: 수신 → 캐시 / 디코드 → 스케줄러 → 송신) ──
+ * 소켓 대기·디코드·추론 동안 루프 스레드를 양보하므로 연결마다 스레드가 필요 없다.
+ * 유휴 연결은 코루틴 프레임과 수신 버퍼만 차지한다.                              */
+co::Task<void> serveStream(int cli, ServerCtx& ctx, Domain& dom)
+{
+    co::EventLoop& loop=*dom.loop;
+    StreamCfg cfg; uint64_t frame_no=0, frame_id=0;
+    bool have_len=false; uint32_t n=0;
+
+    uint32_t word_be;
+    bool ok = co_await loop.recvAll(cli,&word_be,4);
+    if(ok && ntohl(word_be)==HELLO_MAGIC){
+        uint32_t len_be; std::string txt, ack;
+        ok = co_await loop.recvAll(cli,&len_be,4);
+        if(ok && ntohl(len_be)<=MAX_HELLO){
+            txt.resize(ntohl(len_be));
+            ok = co_await loop.recvAll(cli,txt.data(),txt.size());
+        }else ok=false;
+        if(ok && applyHello(txt,cfg,ack)) ok = co_await loop.sendAll(cli,ack.data(),ack.size());
+        else ok=false;
+    }else if(ok){ n=ntohl(word_be); have_len=true; }
+
+    if(ok){
+        if(cfg.name.empty()) cfg.name=ctx.name_prefix+std::to_string(ctx.conn_seq++);
+        cfg.track=ftrace::newTrack("stream "+cfg.name);
+        std::cout<<"🟢 Client connected ("<<cfg.name<<", priority="<<cfg.priority
+                 <<", deadline="<<cfg.deadline_ms<<"ms)\n";
+        if(cfg.sig.empty()) cfg.sig="imgsz="+std::to_string(cfg.imgsz);
+        const uint64_t seed=cacheSeed(cfg);
+
+        // 응답: 결과 한 줄, enc=delta 면 [u32 길이][델타 메시지] (+ render=jpeg 이면 [u32 길이][그린 JPEG], 실패 시 길이 0)
+        ddelta::Encoder enc(cfg.keyframe);
+        std::vector<ddelta::Box> boxes; std::vector<uint8_t> msg;
+        uint64_t text_bytes=0, sent_bytes=0;
+        auto reply=[&](const Result& res, const cv::Mat& frame) -> co::Task<bool> {
+            const bool small = !cfg.fit.empty() && frame.size()==cfg.fit;   // 줄여 받은 프레임에 그리기
+            if(cfg.delta){
+                boxes.clear();
+                for(const auto& d: res.dets) boxes.push_back({d.box.x,d.box.y,d.box.width,d.box.height,d.cls});
+                enc.encode(boxes,msg);
+                const uint32_t len_be=htonl((uint32_t)msg.size());
+                text_bytes+=res.text.size()+1; sent_bytes+=4+msg.size();
+                if(!co_await loop.sendAll(cli,&len_be,4) || !co_await loop.sendAll(cli,msg.data(),msg.size())) co_return false;
+            }else{
+                std::string line=res.text+'\n';
+                if(!co_await loop.sendAll(cli,line.data(),line.size())) co_return false;
+            }
+            if(cfg.render==Render::Jpeg){
+                MjpegHub::Jpeg jpg;
+                if(!frame.empty())
+                    jpg = co_await loop.offload(ctx.render,[&]{
+                        ftrace::Scope ts("render",cfg.track,frame_id);
+                        return renderJpeg(frame, small ? scaleDets(res.dets,cfg.fit_scale) : res.dets);
+                    });
+                uint32_t len_be=htonl(jpg ? (uint32_t)jpg->size() : 0);
+                if(!co_await loop.sendAll(cli,&len_be,4)) co_return false;
+                if(jpg && !co_await loop.sendAll(cli,jpg->data(),jpg->size())) co_return false;
+            }else if(cfg.render==Render::Mjpeg && !frame.empty()){
+                ctx.render.submit([&ctx,name=cfg.name,frame,dets=small ? scaleDets(res.dets,cfg.fit_scale) : res.dets]{
+                    ctx.mjpeg.publish(name,renderJpeg(frame,dets));
+                },RENDER_QUEUE);
+            }
+            co_return true;
+        };
+
+        std::vector<uchar> buf;
+        while(true){
+            if(!have_len){
+                uint32_t len_be; if(!co_await loop.recvAll(cli,&len_be,4)) break;
+                n=ntohl(len_be);
+            }
+            have_len=false;
+            uint64_t cts_be[2]{};                                // [촬영 μs][송신 μs] (ts=1)
+            if(cfg.ts && !co_await loop.recvAll(cli,cts_be,sizeof(cts_be))) break;
+            const int64_t hdr_us=ftrace::nowUs();
+            buf.resize(n);
+            if(!co_await loop.recvAll(cli,buf.data(),n)) break;
+            auto arrived=Clock::now();
+            const int64_t wall_us=std::chrono::duration_cast<std::chrono::microseconds>(
+                                      std::chrono::system_clock::now().time_since_epoch()).count();
+            ++frame_id;
+            if(cfg.track){
+                if(cfg.ts){
+                    const int64_t cap_us=(int64_t)be64toh(cts_be[0]), send_us=(int64_t)be64toh(cts_be[1]);
+                    ftrace::span("client",cfg.track,frame_id,cap_us,send_us);   // 촬영 → 인코드 → 송신 시작
+                    ftrace::span("net",cfg.track,frame_id,send_us,hdr_us);
+                }
+                ftrace::span("recv",cfg.track,frame_id,hdr_us,wall_us);
+            }
+
+            bool hit=false; cv::Mat frame;
+            auto r = co_await inferFrame(ctx,dom,cfg,seed,buf.data(),n,frame_no,frame_id,arrived,frame,hit);
+            if(!r){ if(!co_await reply(Result{},frame)) break; continue; }
+            const Result& res=*r;
+            {   ftrace::Scope ts("send",cfg.track,frame_id);
+                if(!co_await reply(res,frame)) break;
+            }
+            if(cfg.track) ftrace::span("frame",cfg.track,frame_id,hdr_us,ftrace::nowUs());
+            if(ctx.detlog) ctx.detlog->append(cfg.name,toRows(frame_id,wall_us,res.dets));
+            FLOG_EVERY_MS(FLOG_LV_INFO,1000,"{} frame {} dets={} {}ms{}",cfg.name,frame_id,res.dets.size(),
+                          std::chrono::duration<double,std::milli>(Clock::now()-arrived).count(),hit?" (cache)":"");
+        }
+        std::cout<<"🔴 Client disconnected ("<<cfg.name<<")\n";
+        if(cfg.delta) std::cout<<"🟡 delta: "<<enc.keys<<" key / "<<enc.deltas<<" delta, "<<sent_bytes
+                               <<" bytes (text "<<text_bytes<<")\n";
+        dom.sched.report(std::cout);
+        std::cout<<"🟡 cache hit="<<ctx.cache.hits()<<" miss="<<ctx.cache.misses()<<'\n';
+    }
+}
+
+// 연결 하나의 수명. 처리 중 예외(깨진 프레임의 cv::Exception 등)는 이 연결만 닫는다
+co::Task<void> serveClient(int cli, ServerCtx& ctx, Domain& dom)
+{
+    ++ctx.active; ++dom.conns;
+    try{ co_await serveStream(cli,ctx,dom); }
+    catch(const std::exception& e){ FLOG_WARN("client fd {} dropped: {}",cli,e.what()); }
+    dom.loop->close(cli);
+    --dom.conns; --ctx.active;
+}
+
+/* ───── UDP 전송 (--udp[=PORT]) ───────────────────────────────────────────
+ * 손실 많은 링크용. 클라이언트는 JPEG 를 조각 데이터그램으로 보내고 (udp_frames.hpp),
+ * 수신 스레드 하나가 스트림별로 조각을 맞춰 완성된 프레임만 도메인 루프로 넘긴다.
+ * 재전송 없음: 조각이 빠진 프레임은 --udp-deadline 이 지나면 버리고 다음 프레임을 본다.
+ * 추론 중에 완성된 프레임은 가장 최신 것 하나만 남긴다. 결과는 데이터그램 하나.
+ * 스트림 = (보낸 주소, stream 번호). 첫 데이터그램은 Hello (응답을 못 받으면 클라이언트가 재전송).   */
+constexpr int UDP_BATCH    = 64;                  // recvmmsg 한 번에 받는 데이터그램 수
+constexpr int UDP_FRAME_MS = 100;                 // 첫 조각 뒤 이 안에 못 맞추면 버림
+constexpr int UDP_IDLE_SEC = 30;                  // 이만큼 조용한 스트림은 정리
+constexpr int UDP_RCVBUF   = 8<<20;               // 순간 몰림에 커널이 버리지 않게
+
+struct UdpCfg { int port=0; int frame_ms=UDP_FRAME_MS; udpf::LossSim sim; };
+
+struct UdpStream {
+    sockaddr_in peer{}; uint32_t id=0;
+    StreamCfg cfg; uint64_t seed=0; std::string ack;
+    Domain* dom=nullptr;
+    std::unique_ptr<udpf::Reassembler> rx;       // 수신 스레드 전용
+    Clock::time_point seen;
+    std::mutex m;                                // ↓ 수신 스레드 ↔ 루프 코루틴
+    bool busy=false;
+    std::optional<udpf::Frame> next;
+    uint64_t frame_no=0, skipped=0;
+};
+using UdpStreamPtr = std::shared_ptr<UdpStream>;
+
+// 스트림 하나의 완성된 프레임을 차례로 추론하고 결과를 보낸다 (스트림마다 코루틴 하나만)
+co::Task<void> serveUdpFrames(int fd, ServerCtx& ctx, UdpStreamPtr st, udpf::Frame f)
+{
+    Domain& dom=*st->dom; const StreamCfg& cfg=st->cfg;
+    std::vector<uint8_t> out;
+    while(true){
+        const int64_t wall_us=ftrace::nowUs();
+        const uint64_t frame_id=f.id;
+        bool hit=false; cv::Mat frame;
+        std::optional<Result> r;
+        try{ r = co_await inferFrame(ctx,dom,cfg,st->seed,f.buf->data(),f.len,st->frame_no,frame_id,f.first,frame,hit); }
+        catch(const std::exception& e){                  // 깨진 프레임 하나: 빈 결과로 응답하고 스트림은 계속
+            FLOG_WARN("{} frame {} failed: {} (udp)",cfg.name,frame_id,e.what());
+        }
+        f.buf.reset();                                   // 조각 버퍼는 바로 풀로
+        const Result res = r ? std::move(*r) : Result{};
+        if(udpf::HDR+res.text.size()<=udpf::DGRAM_MAX){
+            ftrace::Scope ts("send",cfg.track,frame_id);
+            out.resize(udpf::HDR+res.text.size());
+            udpf::putHdr(out.data(),{udpf::Result,st->id,f.id,0,1});
+            std::memcpy(out.data()+udpf::HDR,res.text.data(),res.text.size());
+            sendto(fd,out.data(),out.size(),MSG_DONTWAIT,(sockaddr*)&st->peer,sizeof(st->peer));   // 막히면 버림
+        }
+        if(cfg.render==Render::Mjpeg && !frame.empty()){
+            const bool small = !cfg.fit.empty() && frame.size()==cfg.fit;
+            ctx.render.submit([&ctx,name=cfg.name,frame,dets=small ? scaleDets(res.dets,cfg.fit_scale) : res.dets]{
+                ctx.mjpeg.publish(name,renderJpeg(frame,dets));
+            },RENDER_QUEUE);
+        }
+        if(cfg.track) ftrace::span("frame",cfg.track,frame_id,
+                                   wall_us-std::chrono::duration_cast<std::chrono::microseconds>(Clock::now()-f.first).count(),
+                                   ftrace::nowUs());
+        if(ctx.detlog) ctx.detlog->append(cfg.name,toRows(frame_id,wall_us,res.dets));
+        FLOG_EVERY_MS(FLOG_LV_INFO,1000,"{} frame {} dets={} {}ms{} (udp)",cfg.name,frame_id,res.dets.size(),
+                      std::chrono::duration<double,std::milli>(Clock::now()-f.first).count(),hit?" (cache)":"");
+
+        std::lock_guard<std::mutex> lk(st->m);
+        if(!st->next){ st->busy=false; --ctx.active; co_return; }
+        f=std::move(*st->next); st->next.reset();
+    }
+}
+
+// 수신 스레드: recvmmsg → (손실 흉내) → Hello 응답 / 조각 맞추기 → 완성 프레임을 루프로
+void udpReceiver(int fd, ServerCtx& ctx, UdpCfg& uc)
+{
+    ftrace::nameThread("udp rx");
+    udpf::BufferPool pool;
+    std::map<std::pair<uint64_t,uint32_t>,UdpStreamPtr> streams;   // (주소:포트, stream 번호)
+    constexpr size_t DG=udpf::HDR+MAX_HELLO;
+    std::vector<uint8_t> bufs(UDP_BATCH*DG);
+    mmsghdr msgs[UDP_BATCH]; iovec iovs[UDP_BATCH]; sockaddr_in froms[UDP_BATCH];
+    const auto frame_deadline=std::chrono::milliseconds(uc.frame_ms);
+    std::vector<uint8_t> out;
+
+    auto handle=[&](const uint8_t* p, size_t n, const sockaddr_in& from, Clock::time_point now){
+        udpf::Hdr h;
+        if(!udpf::getHdr(p,n,h)) return;
+        const auto key=std::make_pair(((uint64_t)from.sin_addr.s_addr<<16)|from.sin_port,h.stream);
+        auto it=streams.find(key);
+        if(h.type==udpf::Hello){
+            if(it==streams.end()){
+                auto st=std::make_shared<UdpStream>();
+                if(!applyHello(std::string((const char*)p+udpf::HDR,n-udpf::HDR),st->cfg,st->ack)) return;
+                if(st->cfg.render==Render::Jpeg){                 // 그린 프레임은 데이터그램 하나에 안 들어간다
+                    FLOG_WARN("udp: render=jpeg is not supported, ignored");
+                    st->cfg.render=Render::None;
+                }
+                if(st->cfg.delta){                                // 결과 데이터그램은 빠질 수 있어 직전 결과를 기준으로 못 삼는다
+                    FLOG_WARN("udp: enc=delta is not supported, ignored");
+                    st->cfg.delta=false;
+                    const auto e=st->ack.find(" enc=delta");      // ack 의 마지막 항목 ('\n' 앞)
+                    st->ack.erase(e,st->ack.size()-1-e);
+                }
+                st->peer=from; st->id=h.stream; st->seen=now;
+                st->rx=std::make_unique<udpf::Reassembler>(pool);
+                if(st->cfg.name.empty()) st->cfg.name=ctx.name_prefix+std::to_string(ctx.conn_seq++);
+                st->cfg.track=ftrace::newTrack("stream "+st->cfg.name);
+                st->seed=cacheSeed(st->cfg);
+                st->dom=&ctx.pick(); ++st->dom->conns;
+                std::cout<<"🟢 UDP client ("<<st->cfg.name<<", priority="<<st->cfg.priority
+                         <<", deadline="<<st->cfg.deadline_ms<<"ms)\n";
+                it=streams.emplace(key,std::move(st)).first;
+            }
+            const std::string& ack=it->second->ack;               // Hello 재전송이면 같은 응답
+            out.resize(udpf::HDR+ack.size());
+            udpf::putHdr(out.data(),{udpf::Hello,h.stream,0,0,1});
+            std::memcpy(out.data()+udpf::HDR,ack.data(),ack.size());
+            sendto(fd,out.data(),out.size(),MSG_DONTWAIT,(const sockaddr*)&from,sizeof(from));
+            return;
+        }
+        if(h.type!=udpf::Frag || it==streams.end()) return;     // Hello 전의 조각은 버림
+        UdpStreamPtr& st=it->second;
+        st->seen=now;
+        udpf::Frame f;
+        if(!st->rx->push(h,p+udpf::HDR,n-udpf::HDR,now,f)) return;
+        if(st->cfg.track){
+            const int64_t t1=ftrace::nowUs();
+            ftrace::span("recv",st->cfg.track,f.id,
+                         t1-std::chrono::duration_cast<std::chrono::microseconds>(now-f.first).count(),t1);
+        }
+        std::lock_guard<std::mutex> lk(st->m);
+        if(st->busy){ if(st->next) ++st->skipped; st->next=std::move(f); return; }
+        st->busy=true; ++ctx.active;                              // 코루틴이 끝날 때 뺀다
+        st->dom->loop->spawn(serveUdpFrames(fd,ctx,st,std::move(f)));
+    };
+
+    auto last_sweep=Clock::now();
+    while(!ctx.stopping){
+        auto now=Clock::now();
+        const auto wait=uc.sim.wait(now,std::chrono::milliseconds(20));
+        pollfd pf{fd,POLLIN,0};
+        poll(&pf,1,(int)std::chrono::duration_cast<std::chrono::milliseconds>(wait).count());
+        now=Clock::now();
+        if(pf.revents&POLLIN){
+            for(int i=0;i<UDP_BATCH;++i){
+                iovs[i]={bufs.data()+i*DG,DG};
+                msgs[i]={}; msgs[i].msg_hdr.msg_iov=&iovs[i]; msgs[i].msg_hdr.msg_iovlen=1;
+                msgs[i].msg_hdr.msg_name=&froms[i]; msgs[i].msg_hdr.msg_namelen=sizeof(froms[i]);
+            }
+            const int k=recvmmsg(fd,msgs,UDP_BATCH,MSG_DONTWAIT,nullptr);
+            for(int i=0;i<k;++i){
+                const uint8_t* p=bufs.data()+i*DG; const size_t n=msgs[i].msg_len;
+                if(uc.sim.admit(p,n,froms[i],now)) handle(p,n,froms[i],now);
+            }
+        }
+        for(udpf::LossSim::Held d; uc.sim.due(now,d); ) handle(d.data.data(),d.data.size(),d.from,now);
+
+        if(now-last_sweep<frame_deadline/4) continue;
+        last_sweep=now;
+        for(auto it=streams.begin(); it!=streams.end(); ){
+            UdpStream& st=*it->second;
+            st.rx->expire(now,frame_deadline);
+            if(now-st.seen<std::chrono::seconds(UDP_IDLE_SEC)){ ++it; continue; }
+            const auto& s=st.rx->stats;
+            std::cout<<"🔴 UDP client gone ("<<st.cfg.name<<") frames="<<s.complete<<" incomplete="<<s.incomplete
+                     <<" late="<<s.stale<<" dup="<<s.dup<<" skipped="<<st.skipped;
+            if(uc.sim.on()) std::cout<<" (sim dropped="<<uc.sim.dropped<<" reordered="<<uc.sim.reordered<<')';
+            std::cout<<'\n';
+            --st.dom->conns;
+            it=streams.erase(it);
+        }
+    }
+}
+
+/* ───── 모델 파일 읽기 전용 매핑 ─────────────────────────────────────────
+ * fork 전에 매핑하면 워커 프로세스들이 같은 물리 페이지를 공유한다.        */
+struct MappedFile {
+    const void* data=nullptr; size_t size=0;
+    explicit MappedFile(const char* path){
+        int fd=open(path,O_RDONLY); if(fd<0) return;
+        struct stat st{};
+        if(fstat(fd,&st)==0 && st.st_size>0){
+            void* p=mmap(nullptr,(size_t)st.st_size,PROT_READ,MAP_SHARED,fd,0);
+            if(p!=MAP_FAILED){ data=p; size=(size_t)st.st_size; }
+        }
+        close(fd);
+    }
+    ~MappedFile(){ if(data) munmap(const_cast<void*>(data),size); }
+};
+
+/* ───── huge page (--hugepages=auto|explicit|thp) ───────────────────────────
+ * 입력·출력 텐서(ShapeSlot), 디코드한 프레임(cv::Mat 기본 할당자), ORT 중간 텐서
+ * (env 공유 할당자)를 huge_alloc.hpp 로. 1MB 미만은 일반 malloc.             */
+class HugeMatAllocator : public cv::MatAllocator {
+public:
+    cv::UMatData* allocate(int dims, const int* sizes, int type, void* data0, size_t* step,
+                           cv::AccessFlag, cv::UMatUsageFlags) const override {
+        size_t total=CV_ELEM_SIZE(type);
+        for(int i=dims-1;i>=0;--i){
+            if(step){
+                if(data0 && step[i]!=CV_AUTOSTEP){ CV_Assert(total<=step[i]); total=step[i]; }
+                else step[i]=total;
+            }
+            total*=sizes[i];
+        }
+        uchar* data = data0 ? (uchar*)data0 : (uchar*)huge::alloc(total);
+        if(!data) throw std::bad_alloc();
+        cv::UMatData* u=new cv::UMatData(this);
+        u->data=u->origdata=data; u->size=total;
+        if(data0) u->flags|=cv::UMatData::USER_ALLOCATED;
+        return u;
+    }
+    bool allocate(cv::UMatData* u, cv::AccessFlag, cv::UMatUsageFlags) const override { return u!=nullptr; }
+    void deallocate(cv::UMatData* u) const override {
+        if(!u) return;
+        if(!(u->flags & cv::UMatData::USER_ALLOCATED)) huge::free(u->origdata);
+        delete u;
+    }
+};
+
+// ORT 에 등록하는 CPU 할당자. 해제된 큰 블록은 huge_alloc 캐시가 재사용하므로 아레나 없이 쓴다.
+struct HugeOrtAllocator : OrtAllocator {
+    Ort::MemoryInfo info=Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator,OrtMemTypeDefault);
+    HugeOrtAllocator(){
+        version=ORT_API_VERSION;
+        OrtAllocator::Alloc=[](OrtAllocator*, size_t n){ return huge::alloc(n); };
+        OrtAllocator::Free =[](OrtAllocator*, void* p){ huge::free(p); };
+        OrtAllocator::Info =[](const OrtAllocator* a)->const OrtMemoryInfo*{
+            return static_cast<const HugeOrtAllocator*>(a)->info;
+        };
+        OrtAllocator::Reserve=nullptr;
+    }
+};
+
+bool parseHugeMode(const std::string& s, huge::Mode& m)
+{
+    if(s=="off")           m=huge::Mode::Off;
+    else if(s=="auto"||s=="1") m=huge::Mode::Auto;      // 값 없이 --hugepages
+    else if(s=="explicit") m=huge::Mode::Explicit;
+    else if(s=="thp")      m=huge::Mode::Thp;
+    else return false;
+    return true;
+}
+
+/* 벤치마크 (--hugebench[=N]): 1080p → 640 레터박스 전처리와 [84,8400] 후처리
+ * (앵커마다 채널 방향 strided 읽기)를 4KB 페이지 / huge page 버퍼로 돌려 비교한다. */
+int hugeBench(int iters, huge::Mode hm)
+{
+    const cv::Size in_sz(INPUT_W,INPUT_H);
+    const int N=(int)anchorCount(in_sz);
+    const ClassFilter f;
+    huge::TlbCounter tlb;
+    std::cout<<"🔵 HUGEBENCH : "<<iters<<" iters, 1920x1080 → "<<in_sz.width<<'x'<<in_sz.height<<", out [84,"<<N<<"]\n";
+    for(huge::Mode m: {huge::Mode::Off, hm}){
+        huge::setMode(m);
+        cv::Mat frame(1080,1920,CV_8UC3); cv::randu(frame,0,255);          // 기본 할당자 = HugeMatAllocator
+        huge::Vector<float> blob((size_t)3*in_sz.area());
+        huge::Vector<float> out((size_t)(4+NUM_CLASSES)*N, 0.f);           // 점수 0: 모든 클래스 채널을 읽고 컷
+        float scale=1.f; size_t dets=0;
+        tlb.start(); auto t0=Clock::now();
+        for(int i=0;i<iters;++i){
+            preprocess(frame,in_sz,blob.data(),scale);
+            dets+=postprocess(out.data(),N,scale,in_sz,f,{}).size();
+        }
+        const double ms=std::chrono::duration<double,std::milli>(Clock::now()-t0).count()/iters;
+        const uint64_t miss=tlb.stop();
+        std::cout<<(m==huge::Mode::Off ? "  4KB pages : " : "  huge pages: ")<<ms<<" ms/iter, dTLB read miss/iter "
+                 <<(tlb.ok() ? std::to_string(miss/iters) : std::string("n/a (perf_event_open 불가)"))<<'\n';
+        (void)dets;
+    }
+    const auto& st=huge::stats();
+    std::cout<<"  mapped: explicit "<<(st.explicit_bytes>>20)<<"MB, THP "<<(st.thp_bytes>>20)<<"MB, fallback "
+             <<st.fallbacks<<", hugetlb miss "<<st.hugetlb_misses<<" (explicit 은 /proc/sys/vm/nr_hugepages 예약 필요)\n";
+    return 0;
+}
+
+/* ───── 트레이스 덤프 (--trace=DIR, kill -USR1) ──────────────────────────
+ * 최근 window 초의 프레임 구간을 DIR/trace_<pid>_<unix>.json 으로. --trace-ort 면
+ * ORT 프로파일러 이벤트도 같은 시간축으로 합친다 (세션당 한 번만 끝낼 수 있어 첫 덤프에만). */
+struct TraceCfg { std::string dir; int window_sec=TRACE_WINDOW_SEC; bool ort=false; };
+
+void dumpTrace(ServerCtx& ctx, const TraceCfg& tc)
+{
+    static std::mutex m; std::lock_guard<std::mutex> lk(m);
+    std::vector<std::string> extra;
+    const int64_t from=ftrace::nowUs()-(int64_t)tc.window_sec*1000000;
+    for(auto& d: ctx.domains){
+        if(!d->ort_prof.exchange(false)) continue;
+        Ort::AllocatorWithDefaultOptions alloc;
+        const int64_t start_us=(int64_t)(d->session->GetProfilingStartTimeNs()/1000);   // ORT ts 는 시작 기준 μs
+        auto file=d->session->EndProfilingAllocated(alloc);
+        std::ifstream in(file.get());
+        std::string json((std::istreambuf_iterator<char>(in)),std::istreambuf_iterator<char>());
+        ftrace::appendEvents(json,start_us,from,extra);
+    }
+    const std::string path=tc.dir+"/trace_"+std::to_string(getpid())+"_"+std::to_string(ftrace::nowUs()/1000000)+".json";
+    long n=ftrace::dump(path,tc.window_sec,extra);
+    if(n<0) FLOG_ERROR("trace dump failed: {}",path);
+    else    FLOG_INFO("trace dump: {} ({} spans, {} ort events)",path,n,extra.size());
+}
+
+// 추론 워커·풀 스레드를 띄운 뒤의 종료. 분리된 스레드가 Scheduler·Session·TaskPool 을
+// 아직 쓰고 있으므로 소멸자를 돌리지 않는다: 출력과 로그만 비우고 _exit.
+[[noreturn]] void exitNow(int rc)
+{
+    std::cout.flush(); std::cerr.flush();
+    flog::Logger::get().shutdown();
+    _exit(rc);
+}
 
 int main(int argc,char* argv[])
 {
-    if(argc<4){std::cerr<<"Usage: "<<argv[0]<<" <bind_ip> <port> <model.onnx>\n";return 1;}
-    const char* BIND_IP=argv[1]; int PORT=std::stoi(argv[2]); const char* MODEL=argv[3];
+    /* ── 인자: 위치 인자 + --key=value 옵션 ── */
+    std::vector<std::string> pos; std::map<std::string,std::string> opt;
+    for(int i=1;i<argc;++i){
+        std::string a=argv[i];
+        if(a.rfind("--",0)==0){ auto kv=parseKV(a.substr(2)); opt.insert(kv.begin(),kv.end()); }
+        else pos.push_back(a);
+    }
+
+    /* ── huge page: 할당자는 버퍼를 만들기 전에 바꾼다 ── */
+    huge::Mode HUGEPAGES=huge::Mode::Off;
+    if(opt.count("hugepages") && !parseHugeMode(opt["hugepages"],HUGEPAGES)){
+        std::cerr<<"❌ --hugepages=auto|explicit|thp|off\n"; return 1;
+    }
+    static HugeMatAllocator mat_alloc;
+    if(HUGEPAGES!=huge::Mode::Off || opt.count("hugebench")){
+        huge::setMode(HUGEPAGES);
+        cv::Mat::setDefaultAllocator(&mat_alloc);
+    }
+    if(opt.count("hugebench")){
+        const int iters = opt["hugebench"]=="1" ? 200 : std::max(1, std::stoi(opt["hugebench"]));   // 값 없으면 200
+        return hugeBench(iters, HUGEPAGES==huge::Mode::Off ? huge::Mode::Auto : HUGEPAGES);
+    }
 
-    std::cout<<"🔵 BIND_IP : "<<BIND_IP<<'\n';
-    std::cout<<"🔵 PORT : " << PORT << '\n';
+    const bool VERIFY = opt.count("verify")>0;           // 골든 회귀 검사도 배치처럼 서버 없이 돈다
+    if(VERIFY && opt.count("verify-pre")) return runVerifyPre(opt);   // 전처리만: 모델 없이
+    const bool BATCH = opt.count("batch")>0 || VERIFY;
+    if(pos.size() < (VERIFY ? 1u : BATCH ? 2u : 3u)){
+        std::cerr<<"Usage: "<<argv[0]<<" <bind_ip> <port> <model.onnx> [workers] [--mjpeg=PORT] [--detlog=DIR] [--procs=N] [--numa=0|1]\n"
+                 <<"                 [--trace=DIR [--trace-sec=S] [--trace-ort]]   (kill -USR1 → DIR/trace_*.json)\n"
+                 <<"                 [--mosaic=G]   (작은 프레임 G×G 장을 캔버스 하나로 추론)\n"
+                 <<"                 [--hugepages=auto|explicit|thp]   (텐서·프레임·ORT 버퍼를 2MB 페이지로)\n"
+                 <<"                 [--udp[=PORT] [--udp-deadline=MS] [--udp-sim=loss=P,reorder=P,dup=P,delay=MS]]\n"
+                 <<"       "<<argv[0]<<" --hugebench[=N] [--hugepages=...]   (4KB / huge page 전처리·후처리 비교)\n"
+                 <<"       "<<argv[0]<<" --batch <model.onnx> <video|image|dir>... [--out=results.jsonl] [--detlog=DIR]\n"
+                 <<"                 [--workers=N] [--batch-size=B] [--readers=R]\n"
+                 <<"       "<<argv[0]<<" --verify=DIR <model.onnx> [--verify-record] [--verify-golden=FILE] [--verify-tol=T]\n"
+                 <<"                 [--verify-iou=I] [--verify-lat=R] [--verify-miss=N]   (골든 출력 대비 텐서·검출·지연 회귀 검사)\n"
+                 <<"       "<<argv[0]<<" --verify=DIR --verify-pre   (모델 없이 전처리 입력 텐서만 비교)\n";
+        return 1;
+    }
+    const char* MODEL = BATCH ? pos[0].c_str() : pos[2].c_str();
+    const unsigned HW = std::max(1u, std::thread::hardware_concurrency());
+    int WORKERS = opt.count("workers") ? std::stoi(opt["workers"])
+                : BATCH ? (int)HW                                   // 배치: 코어마다 워커 1개
+                : pos.size()>3 ? std::stoi(pos[3]) : (int)std::max(1u, HW/4);
+    int MAX_BATCH = opt.count("batch-size") ? std::max(1, std::stoi(opt["batch-size"])) : 1;
+
+    /* ── 트레이스: 구간 링은 스레드를 만들기 전에 켠다 ── */
+    TraceCfg TRACE;
+    if(opt.count("trace")){
+        TRACE.dir=opt["trace"];
+        if(opt.count("trace-sec")) TRACE.window_sec=std::max(1, std::stoi(opt["trace-sec"]));
+        TRACE.ort=opt.count("trace-ort")>0;
+        ftrace::enable(TRACE_SLOTS);
+        std::cout<<"🔵 TRACE : "<<TRACE.dir<<" (last "<<TRACE.window_sec<<"s on SIGUSR1"<<(TRACE.ort ? ", +ORT profile" : "")<<")\n";
+    }
+
+    /* ── UDP: --udp[=PORT] (기본은 TCP 와 같은 번호), --udp-deadline=MS, --udp-sim=loss=P,reorder=P,... ── */
+    UdpCfg UDP;
+    if(!BATCH && opt.count("udp")){
+        UDP.port = opt["udp"]=="1" ? std::stoi(pos[1]) : std::stoi(opt["udp"]);
+        if(opt.count("udp-deadline")) UDP.frame_ms=std::max(1, std::stoi(opt["udp-deadline"]));
+        if(opt.count("udp-sim") && !UDP.sim.configure(opt["udp-sim"])){
+            std::cerr<<"❌ --udp-sim=loss=P,reorder=P,dup=P,delay=MS,seed=N\n"; return 1;
+        }
+    }
+
+    if(!BATCH){
+        std::cout<<"🔵 BIND_IP : "<<pos[0]<<'\n';
+        std::cout<<"🔵 PORT : " << pos[1] << '\n';
+    }
     std::cout<<"🔵 MODEL : " << MODEL << '\n';
+    std::cout<<"🔵 WORKERS : " << WORKERS << '\n';
+
+    /* ── 모델 매핑 → (--procs) 워커 프로세스 fork. 스레드를 만들기 전에 해야 한다 ── */
+    MappedFile model(MODEL);
+    if(!model.data){ perror(MODEL); return 1; }
+    model_id = contentHash(model.data, model.size);
+    const int PROCS = BATCH ? 1 : opt.count("procs") ? std::max(1, std::stoi(opt["procs"])) : 1;
+    const int PROC  = PROCS>1 ? superviseProcs(PROCS) : 0;
+    if(PROCS==1){                                         // 단일 프로세스: 덤프 시그널만 받는다
+        struct sigaction sa{}; sa.sa_handler=onSignal; sa.sa_flags=SA_RESTART;
+        sigaction(SIGUSR1,&sa,nullptr);
+    }
+
+    /* ── NUMA: 노드가 둘 이상이면 기본으로 켬 (--numa=0 으로 끔). --procs 면 프로세스마다 노드 하나 ── */
+    auto nodes = numaNodes();
+    const bool NUMA = opt.count("numa") ? opt["numa"]!="0" : nodes.size()>1;
+    if(!NUMA)        nodes.resize(1);
+    else if(PROCS>1) nodes = {nodes[PROC % nodes.size()]};
 
-    /* ── ORT 세션 ── */
+    /* ── ORT 세션: 도메인마다 하나 (도메인 안의 워커들이 공유, Run() 은 thread-safe) ── */
     Ort::Env env(ORT_LOGGING_LEVEL_WARNING,"srv");
-    Ort::SessionOptions so; so.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
-    Ort::Session session(env, MODEL, so);
+    static HugeOrtAllocator ort_alloc;                    // 세션보다 오래 살아야 함
+    if(HUGEPAGES!=huge::Mode::Off){
+        Ort::ThrowOnError(Ort::GetApi().RegisterAllocator(env,&ort_alloc));
+        std::cout<<"🔵 HUGEPAGES : "<<opt["hugepages"]<<" (tensors, frames, ORT allocations)\n";
+    }
+    auto makeSession=[&](int intra, int node){
+        Ort::SessionOptions so; so.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+        if(intra>0) so.SetIntraOpNumThreads(intra);
+        if(TRACE.ort){                                    // 파일 이름에 시각이 붙으므로 프로세스·노드로 구분
+            std::string pre=TRACE.dir+"/ort_"+std::to_string(getpid())+"_n"+std::to_string(node);
+            so.EnableProfiling(pre.c_str());
+        }
+        so.AddConfigEntry("session.use_ort_model_bytes_directly","1");   // .ort 모델이면 매핑을 복사 없이 사용
+        if(HUGEPAGES!=huge::Mode::Off) so.AddConfigEntry("session.use_env_allocators","1");
+        return std::make_unique<Ort::Session>(env, model.data, model.size, so);
+    };
+    ServerCtx ctx;
+    for(auto& n: nodes){
+        auto d=std::make_unique<Domain>();
+        d->node=n.id; d->cpus=n.cpus; d->pin=NUMA;
+        const int intra = BATCH ? 1                      // 배치: 코어는 워커 수로 채운다
+                        : NUMA  ? (int)n.cpus.size() : 0;
+        // 노드에 고정된 스레드에서 만들면 가중치·intra-op 스레드풀도 그 노드에 붙는다
+        if(d->pin) std::thread([&]{ pinThread(d->cpus); d->session=makeSession(intra,n.id); }).join();
+        else       d->session=makeSession(intra,n.id);
+        d->ort_prof=TRACE.ort;
+        ctx.domains.push_back(std::move(d));
+    }
+    Ort::Session& session=*ctx.domains[0]->session;
     Ort::MemoryInfo mem = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator,OrtMemTypeCPU);
 
-    /* ── 입력·출력 이름 (수명 보장) ── */
+    /* ── 입력·출력 이름 ── */
     Ort::AllocatorWithDefaultOptions alloc;
-    static std::vector<std::string>  in_strs,  out_strs;
-    static std::vector<const char*>  in_names, out_names;
 
 #if defined(ORT_API_VERSION) && ORT_API_VERSION >= 18
     in_strs  = session.GetInputNames();
@@ -154,44 +1000,124 @@ int main(int argc,char* argv[])
     for(auto& s: in_strs)  in_names.push_back(s.c_str());
     for(auto& s: out_strs) out_names.push_back(s.c_str());
 
+    /* ── 입력 형태: [1,3,H,W] (uint8 모델은 [1,H,W,3]) 의 H·W 가 -1(심볼릭)이면 동적 입력 모델 ── */
+    {   auto info = session.GetInputTypeInfo(0).GetTensorTypeAndShapeInfo();
+        auto shp  = info.GetShape();
+        u8_input  = info.GetElementType()==ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8;
+        const int hi = u8_input ? 1 : 2, wi = hi+1;
+        if(shp.size()==4 && shp[hi]>0 && shp[wi]>0) model_in = cv::Size((int)shp[wi], (int)shp[hi]);
+        else dyn_input = true;
+        if(MAX_BATCH>1 && !shp.empty() && shp[0]>0){
+            std::cerr<<"⚠️  model batch axis is fixed ("<<shp[0]<<"), --batch-size ignored\n";
+            MAX_BATCH=1;
+        }
+        auto oshp = session.GetOutputTypeInfo(0).GetTensorTypeAndShapeInfo().GetShape();
+        if(!oshp.empty() && oshp.back()==6 && (oshp.size()==2 || oshp.size()==3)){
+            e2e_rank=(int)oshp.size();
+            if(e2e_rank==2 && MAX_BATCH>1){
+                std::cerr<<"⚠️  NMS output [num_dets,6] has no batch axis, --batch-size ignored\n";
+                MAX_BATCH=1;
+            }
+        }else{
+            if(oshp.size()==3 && oshp[1]>0) out_ch = oshp[1];
+            if(oshp.size()==3 && oshp[2]>0) out_n  = oshp[2];
+        }
+    }
+    mosaic_grid = opt.count("mosaic") ? std::max(0, std::stoi(opt["mosaic"])) : 0;
+    if(mosaic_grid==1) mosaic_grid=0;
+    if(mosaic_grid && e2e_rank){
+        // 그래프 안 NMS·top-K 는 캔버스 전체에 걸려 칸끼리 박스가 섞이고 잘린다
+        std::cerr<<"⚠️  NMS 내장 모델(e2e 출력)은 모자이크를 지원하지 않음, --mosaic ignored\n";
+        mosaic_grid=0;
+    }
+    if(mosaic_grid) std::cout<<"🔵 MOSAIC : "<<mosaic_grid<<'x'<<mosaic_grid<<", cell "
+                             <<mosaicCell().width<<'x'<<mosaicCell().height<<'\n';
+    std::cout<<"🔵 INPUT : "<<(dyn_input ? std::string("dynamic (stride 32)")
+                                        : std::to_string(model_in.width)+"x"+std::to_string(model_in.height))
+             <<(u8_input ? ", uint8 NHWC (전처리는 그래프 안에서)" : "")
+             <<(e2e_rank ? ", OUTPUT : [num_dets,6] (NMS 는 그래프 안에서)" : "")<<'\n';
+
+    /* ── 추론 워커 (도메인마다 나눠서, NUMA 면 노드 CPU 에 고정) ── */
+    if(PROCS>1) ctx.name_prefix="p"+std::to_string(PROC)+"s";
+    const int per_dom = std::max(1, WORKERS/(int)ctx.domains.size());
+    for(auto& dp: ctx.domains){
+        Domain* d=dp.get();
+        if(NUMA) std::cout<<"🔵 NUMA node"<<d->node<<" : "<<d->cpus.size()<<" cpus, "<<per_dom<<" workers\n";
+        for(int i=0;i<per_dom;++i)
+            std::thread([d,&mem,MAX_BATCH,i]{
+                if(d->pin) pinThread(d->cpus);
+                ftrace::nameThread("infer n"+std::to_string(d->node)+" #"+std::to_string(i));
+                inferWorker(*d->session,mem,d->sched,MAX_BATCH);
+            }).detach();
+    }
+    if(opt.count("detlog")){
+        ctx.detlog=std::make_unique<DetLogWriter>(opt["detlog"]);
+        std::cout<<"🔵 DETLOG : "<<opt["detlog"]<<"/<stream>.dlog\n";
+    }
+    if(VERIFY) exitNow(runVerify(*ctx.domains[0],session,opt));  // 분리된 추론 워커가 ctx 를 쓰는 중이라 소멸자를 돌리지 않는다
+    if(BATCH){
+        int rc=runBatch(ctx.domains,ctx.detlog.get(),{pos.begin()+1,pos.end()},opt);
+        ctx.detlog.reset();                               // 남은 로그 배치 기록
+        if(!TRACE.dir.empty()) dumpTrace(ctx,TRACE);      // 배치는 끝날 때 한 번
+        exitNow(rc);
+    }
+    if(opt.count("mjpeg") && !ctx.mjpeg.listenOn(pos[0],std::stoi(opt["mjpeg"])+PROC)) exitNow(1);   // 프로세스마다 포트+번호
+
+    /* ── 도메인마다 이벤트 루프 스레드 1개 + 디코드 풀 (NUMA 면 노드에 고정) ── */
+    for(auto& dp: ctx.domains){
+        Domain* d=dp.get();
+        auto pin=[d]{ if(d->pin) pinThread(d->cpus); };
+        const std::string n=std::to_string(d->node);
+        d->cpu =std::make_unique<TaskPool>(per_dom,[pin,n]{ pin(); ftrace::nameThread("decode n"+n); });
+        d->loop=std::make_unique<co::EventLoop>();
+        std::thread([d,pin,n]{ pin(); ftrace::nameThread("loop n"+n); d->loop->run(); }).detach();
+    }
+    {   rlimit rl{};                                      // 유휴 연결 수만 개를 받을 수 있게 fd 한도 올림
+        if(getrlimit(RLIMIT_NOFILE,&rl)==0){ rl.rlim_cur=rl.rlim_max; setrlimit(RLIMIT_NOFILE,&rl); }
+    }
+
     /* ── TCP 서버 ── */
+    const char* BIND_IP=pos[0].c_str(); int PORT=std::stoi(pos[1]);
     int srv=socket(AF_INET,SOCK_STREAM,0);
     sockaddr_in addr{}; addr.sin_family=AF_INET; addr.sin_port=htons(PORT);
     inet_pton(AF_INET,BIND_IP,&addr.sin_addr);
     int yes=1; setsockopt(srv,SOL_SOCKET,SO_REUSEADDR,&yes,sizeof(yes));
-    if(bind(srv,(sockaddr*)&addr,sizeof(addr))<0||listen(srv,1)<0){perror("socket");return 1;}
-    std::cout<<"🔵 Listening on "<<BIND_IP<<':'<<PORT<<'\n';
-
-    while(true){
-        int cli=accept(srv,nullptr,nullptr); if(cli<0)continue;
-        std::cout<<"🟢 Client connected\n";
-
-        std::vector<float> blob(INPUT_W*INPUT_H*3);
-
-        while(true){
-            uint32_t len_be; if(!recvAll(cli,&len_be,4)) break;
-            uint32_t n=ntohl(len_be); std::vector<uchar> buf(n);
-            if(!recvAll(cli,buf.data(),n)) break;
-
-            cv::Mat img=cv::imdecode(buf,cv::IMREAD_COLOR); if(img.empty()) continue;
-
-            float scale; Ort::Value input=preprocess(img,blob,scale,mem);
-
-            std::vector<Ort::Value> outs;
-            try{
-                outs=session.Run(Ort::RunOptions{nullptr},
-                                 in_names.data(), &input, in_names.size(),
-                                 out_names.data(), out_names.size());
-            }catch(const Ort::Exception& e){
-                std::cerr<<"Run() failed: "<<e.what()<<'\n'; break;
-            }
+    if(PROCS>1) setsockopt(srv,SOL_SOCKET,SO_REUSEPORT,&yes,sizeof(yes));
+    if(bind(srv,(sockaddr*)&addr,sizeof(addr))<0||listen(srv,SOMAXCONN)<0){perror("socket");exitNow(1);}
+    std::cout<<"🔵 Listening on "<<BIND_IP<<':'<<PORT<<(PROCS>1 ? " (proc "+std::to_string(PROC)+")" : "")<<'\n';
+    if(UDP.port){
+        int us=socket(AF_INET,SOCK_DGRAM,0);
+        sockaddr_in ua=addr; ua.sin_port=htons(UDP.port);
+        setsockopt(us,SOL_SOCKET,SO_RCVBUF,&UDP_RCVBUF,sizeof(UDP_RCVBUF));
+        if(PROCS>1) setsockopt(us,SOL_SOCKET,SO_REUSEPORT,&yes,sizeof(yes));   // 보낸 주소별로 한 프로세스에 고정
+        if(bind(us,(sockaddr*)&ua,sizeof(ua))<0){ perror("udp"); exitNow(1); }
+        std::cout<<"🔵 UDP on "<<BIND_IP<<':'<<UDP.port<<" (frame deadline "<<UDP.frame_ms<<"ms"
+                 <<(UDP.sim.on() ? ", loss sim "+opt["udp-sim"] : std::string())<<")\n";
+        std::thread([us,&ctx,&UDP]{ udpReceiver(us,ctx,UDP); }).detach();
+    }
+    if(ready_fd>=0){ (void)!write(ready_fd,"r",1); close(ready_fd); }
 
-            std::string payload=postprocess(outs[0],scale,img.size());
-            payload.push_back('\n');
-            if(!sendAll(cli,payload.data(),payload.size())) break;
+    while(!sig_term){
+        if(sig_dump){
+            sig_dump=0;
+            if(TRACE.dir.empty()) FLOG_WARN("SIGUSR1: tracing is off (--trace=DIR)");
+            else std::thread([&ctx,TRACE]{ dumpTrace(ctx,TRACE); }).detach();
         }
-        std::cout<<"🔴 Client disconnected\n";
-        close(cli);
+        pollfd pf{srv,POLLIN,0};                          // 시그널이 다른 스레드로 가도 0.5초 안에 종료 확인
+        if(poll(&pf,1,500)<=0) continue;
+        int cli=accept4(srv,nullptr,nullptr,SOCK_NONBLOCK); if(cli<0)continue;
+        Domain& d=ctx.pick();
+        d.loop->spawn(serveClient(cli,ctx,d));
     }
-    close(srv); return 0;
-}
\ No newline at end of file
+
+    /* ── (--procs 워커) SIGTERM: 새 연결은 다른 워커로, 진행 중인 연결은 마무리 ── */
+    close(srv);
+    ctx.stopping=true;
+    for(int s=0; s<DRAIN_SEC*10 && ctx.active>0; ++s)
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    if(ctx.active>0) std::cout<<"🟡 "<<ctx.active<<" connections/streams still busy after "<<DRAIN_SEC<<"s, stopping\n";
+    for(auto& d: ctx.domains) d->loop->stop();       // 남은 코루틴이 더는 돌지 않으므로 detlog 를 닫아도 된다
+    ctx.detlog.reset();
+    std::cout<<"🔴 PROC "<<PROC<<" stopped\n";
+    exitNow(0);
+}
@@ -0,0 +1,246 @@
+// fast_log.hpp
+// 핫패스용 로거. 호출 스레드는 자기 링 버퍼(SPSC, lock-free)에 인자만 복사하고
+// 문자열 포맷·출력은 백그라운드 스레드가 한다. std::cout 잠금 경합이 없다.
+//   FLOG_INFO("pred {} cls={} conf={}", i, cls, conf);
+//   FLOG_EVERY_N (FLOG_LV_DEBUG, 100,  "...", ...);   // 호출 100번에 1번
+//   FLOG_EVERY_MS(FLOG_LV_INFO,  1000, "...", ...);   // 1초에 최대 1번
+// -DFLOG_LEVEL=n 보다 낮은 레벨 호출은 컴파일 단계에서 사라진다. (0=DEBUG 1=INFO 2=WARN 3=ERROR)
+// 링이 가득 차면 기다리지 않고 버리며, 버린 수는 다음 줄에 표시된다.
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#define FLOG_LV_DEBUG 0
+#define FLOG_LV_INFO  1
+#define FLOG_LV_WARN  2
+#define FLOG_LV_ERROR 3
+#ifndef FLOG_LEVEL
+#  define FLOG_LEVEL FLOG_LV_INFO
+#endif
+
+namespace flog {
+
+constexpr size_t RING_SLOTS = 512;       // 스레드당 대기 레코드 수
+constexpr size_t PAYLOAD    = 480;       // 레코드당 인자 저장 공간
+constexpr size_t STR_MAX    = 200;       // 문자열 인자는 이 길이에서 잘림
+
+/* ───── 인자 저장 형식 ───────────────────────────────────────────────────
+ * 산술형은 값 그대로, 문자열(std::string / const char*)은 고정 버퍼로 복사.
+ * 포인터를 들고 있지 않으므로 호출 직후 원본이 사라져도 안전하다.          */
+struct Str {
+    uint16_t len = 0; char s[STR_MAX];
+    Str(const char* p, size_t n) { len = (uint16_t)std::min(n, STR_MAX); std::memcpy(s, p, len); }
+};
+
+template <class T, class = void> struct Stored { using type = T; };
+template <class T> struct Stored<T, std::enable_if_t<std::is_convertible<const T&, std::string>::value>> { using type = Str; };
+
+inline Str store(const std::string& v) { return Str(v.data(), v.size()); }
+inline Str store(const char* v)        { return Str(v, v ? std::strlen(v) : 0); }
+template <class T, class = std::enable_if_t<std::is_arithmetic<T>::value>>
+inline T store(T v) { return v; }
+
+inline void put(std::string& o, const Str& v) { o.append(v.s, v.len); if (v.len == STR_MAX) o += "…"; }
+inline void put(std::string& o, bool v)       { o += v ? "true" : "false"; }
+inline void put(std::string& o, char v)       { o += v; }
+inline void put(std::string& o, double v)     { char b[32]; std::snprintf(b, sizeof(b), "%g", v); o += b; }
+inline void put(std::string& o, float v)      { put(o, (double)v); }
+template <class T, class = std::enable_if_t<std::is_integral<T>::value>>
+inline void put(std::string& o, T v)          { o += std::to_string(v); }
+
+// fmt 의 다음 "{}" 까지 복사하고 그 자리에 v 를 넣는다
+template <class T>
+void emit(std::string& o, const char*& fmt, const T& v) {
+    const char* p = std::strstr(fmt, "{}");
+    if (!p) { o += ' '; put(o, v); return; }
+    o.append(fmt, p - fmt); put(o, v); fmt = p + 2;
+}
+
+template <class Tup, size_t... I>
+void formatTuple(std::string& o, const char* fmt, const Tup& t, std::index_sequence<I...>) {
+    (emit(o, fmt, std::get<I>(t)), ...);
+    o += fmt;
+}
+template <class Tup>
+void formatRecord(std::string& o, const char* fmt, const void* payload) {
+    formatTuple(o, fmt, *static_cast<const Tup*>(payload), std::make_index_sequence<std::tuple_size<Tup>::value>{});
+}
+
+struct Record {
+    int64_t     ts_us;
+    const char* fmt;                                    // 문자열 리터럴만 (FLOG_* 매크로가 보장)
+    void      (*format)(std::string&, const char*, const void*);
+    void      (*destroy)(void*);
+    int         level;
+    uint32_t    tid;
+    alignas(std::max_align_t) unsigned char payload[PAYLOAD];
+};
+
+/* ───── 스레드별 SPSC 링 (생산자 = 로그 호출 스레드, 소비자 = 출력 스레드) ── */
+struct Ring {
+    alignas(64) std::atomic<uint64_t> head{0};
+    alignas(64) std::atomic<uint64_t> tail{0};
+    alignas(64) std::atomic<uint64_t> dropped{0};
+    std::atomic<bool> dead{false};                      // 스레드 종료 → 비운 뒤 회수
+    uint32_t tid = 0;
+    Record slots[RING_SLOTS];
+};
+
+inline int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+}
+inline int64_t steadyMs() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+class Logger {
+public:
+    static Logger& get() { static Logger l; return l; }
+
+    template <class... A>
+    void push(int level, const char* fmt, const A&... args) {
+        using Tup = std::tuple<typename Stored<std::decay_t<A>>::type...>;
+        static_assert(sizeof(Tup) <= PAYLOAD, "log arguments too large");
+        Ring& r = ring();
+        uint64_t h = r.head.load(std::memory_order_relaxed);
+        if (h - r.tail.load(std::memory_order_acquire) >= RING_SLOTS) {
+            r.dropped.fetch_add(1, std::memory_order_relaxed); return;
+        }
+        Record& rec = r.slots[h % RING_SLOTS];
+        rec.ts_us = nowUs(); rec.fmt = fmt; rec.level = level; rec.tid = r.tid;
+        new (rec.payload) Tup(store(args)...);
+        rec.format  = &formatRecord<Tup>;
+        rec.destroy = [](void* p){ static_cast<Tup*>(p)->~Tup(); };
+        r.head.store(h + 1, std::memory_order_release);
+    }
+
+    // 남은 기록을 모두 내보내고 소비자 스레드를 멈춘다. 소멸자 없이 _exit 하기 전에 부른다
+    void shutdown() {
+        { std::lock_guard<std::mutex> lk(m_); stop_ = true; }
+        cv_.notify_one();
+        if (th_.joinable()) th_.join();
+    }
+
+    ~Logger() { shutdown(); }
+
+private:
+    struct Handle {                                     // thread_local: 스레드가 끝나면 링을 dead 로 표시
+        Ring* r;
+        ~Handle() { r->dead.store(true, std::memory_order_release); }
+    };
+
+    Logger() : th_([this]{ run(); }) {}
+
+    Ring& ring() {
+        thread_local Handle h{ attach() };
+        return *h.r;
+    }
+
+    Ring* attach() {
+        auto r = std::make_unique<Ring>();
+        std::lock_guard<std::mutex> lk(m_);
+        r->tid = next_tid_++;
+        rings_.push_back(std::move(r));
+        return rings_.back().get();
+    }
+
+    // 링 하나를 비운다 (소비자 스레드 전용)
+    void drain(Ring& r, std::vector<std::pair<int64_t, std::string>>& out) {
+        uint64_t t = r.tail.load(std::memory_order_relaxed);
+        uint64_t h = r.head.load(std::memory_order_acquire);
+        if (uint64_t d = r.dropped.exchange(0, std::memory_order_relaxed))
+            out.emplace_back(t < h ? r.slots[t % RING_SLOTS].ts_us : nowUs(),
+                             "[W t" + std::to_string(r.tid) + "] dropped " + std::to_string(d) + " log records");
+        for (; t < h; ++t) {
+            Record& rec = r.slots[t % RING_SLOTS];
+            std::string line = prefix(rec);
+            rec.format(line, rec.fmt, rec.payload);
+            rec.destroy(rec.payload);
+            out.emplace_back(rec.ts_us, std::move(line));
+        }
+        r.tail.store(h, std::memory_order_release);
+    }
+
+    static std::string prefix(const Record& rec) {
+        static const char LV[] = "DIWE";
+        std::time_t sec = rec.ts_us / 1000000; std::tm tm{}; localtime_r(&sec, &tm);
+        char b[48];
+        std::snprintf(b, sizeof(b), "[%c %02d:%02d:%02d.%03d t%u] ", LV[rec.level & 3],
+                      tm.tm_hour, tm.tm_min, tm.tm_sec, (int)(rec.ts_us / 1000 % 1000), rec.tid);
+        return b;
+    }
+
+    void flushAll() {
+        std::vector<Ring*> live, dead;
+        {   std::lock_guard<std::mutex> lk(m_);
+            for (auto& r : rings_) (r->dead.load(std::memory_order_acquire) ? dead : live).push_back(r.get());
+        }
+        std::vector<std::pair<int64_t, std::string>> out;
+        for (Ring* r : live) drain(*r, out);
+        for (Ring* r : dead) drain(*r, out);            // dead 표시 이후엔 더 쓰지 않으므로 비우면 끝
+        std::stable_sort(out.begin(), out.end(),
+                         [](const auto& a, const auto& b){ return a.first < b.first; });
+        std::string buf;
+        for (auto& l : out) { buf += l.second; buf += '\n'; }
+        if (!buf.empty()) { std::fwrite(buf.data(), 1, buf.size(), stdout); std::fflush(stdout); }
+
+        if (!dead.empty()) {
+            std::lock_guard<std::mutex> lk(m_);
+            rings_.erase(std::remove_if(rings_.begin(), rings_.end(), [&](const auto& r){
+                return std::find(dead.begin(), dead.end(), r.get()) != dead.end();
+            }), rings_.end());
+        }
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lk(m_);
+        while (!stop_) {
+            cv_.wait_for(lk, std::chrono::milliseconds(5), [this]{ return stop_; });
+            lk.unlock(); flushAll(); lk.lock();
+        }
+        lk.unlock(); flushAll();
+    }
+
+    std::mutex m_; std::condition_variable cv_;
+    bool stop_ = false;
+    uint32_t next_tid_ = 0;
+    std::vector<std::unique_ptr<Ring>> rings_;
+    std::thread th_;                                    // 마지막 멤버: 나머지가 준비된 뒤 시작
+};
+
+}  // namespace flog
+
+#define FLOG_AT(lv, ...) \
+    do { if constexpr ((lv) >= FLOG_LEVEL) ::flog::Logger::get().push((lv), __VA_ARGS__); } while (0)
+#define FLOG_DEBUG(...) FLOG_AT(FLOG_LV_DEBUG, __VA_ARGS__)
+#define FLOG_INFO(...)  FLOG_AT(FLOG_LV_INFO,  __VA_ARGS__)
+#define FLOG_WARN(...)  FLOG_AT(FLOG_LV_WARN,  __VA_ARGS__)
+#define FLOG_ERROR(...) FLOG_AT(FLOG_LV_ERROR, __VA_ARGS__)
+
+// 호출 위치별 샘플링: n 번에 1번 / ms 마다 최대 1번
+#define FLOG_EVERY_N(lv, n, ...) do { if constexpr ((lv) >= FLOG_LEVEL) { \
+    static std::atomic<uint64_t> flog_cnt_{0}; \
+    if (flog_cnt_.fetch_add(1, std::memory_order_relaxed) % (n) == 0) FLOG_AT(lv, __VA_ARGS__); } } while (0)
+#define FLOG_EVERY_MS(lv, ms, ...) do { if constexpr ((lv) >= FLOG_LEVEL) { \
+    static std::atomic<int64_t> flog_last_{INT64_MIN / 2}; \
+    int64_t flog_now_ = ::flog::steadyMs(), flog_prev_ = flog_last_.load(std::memory_order_relaxed); \
+    if (flog_now_ - flog_prev_ >= (ms) && flog_last_.compare_exchange_strong(flog_prev_, flog_now_, std::memory_order_relaxed)) \
+        FLOG_AT(lv, __VA_ARGS__); } } while (0)
@@ -0,0 +1,195 @@
+// frame_trace.hpp
+// 프레임 단위 구간 기록 → Chrome trace JSON (ui.perfetto.dev / chrome://tracing 에서 열기).
+// 스레드마다 자기 링(단일 생산자, 가득 차면 오래된 것부터 덮어씀)에 구간만 적어 두고
+// dump() 가 마지막 window 초를 모아 파일로 쓴다. 꺼져 있으면 기록은 분기 하나로 끝난다.
+//   ftrace::enable(65536);                              // 스레드당 구간 수
+//   uint32_t tr = ftrace::newTrack("cam1");             // 스트림 트랙 (0 = 호출 스레드 트랙)
+//   { ftrace::Scope s("decode", tr, frame); ... }       // 끝날 때 기록
+//   ftrace::span("net", tr, frame, send_us, recv_us);   // 이미 아는 구간
+//   ftrace::dump("trace.json", 10);
+// 시각은 system_clock μs 라서 클라이언트가 보낸 촬영 시각과 같은 축에 놓인다 (NTP 동기 가정).
+#pragma once
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace ftrace {
+
+inline int64_t nowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+struct Span {
+    const char* name;                                   // 문자열 리터럴만
+    int64_t     ts_us, dur_us;
+    uint32_t    track, frame;
+};
+
+/* ───── 스레드별 링: 슬롯마다 seqlock (쓰는 중이면 홀수) ───────────────────
+ * 덤프는 쓰기를 멈추지 않고 읽다가 읽는 사이 덮어써진 슬롯만 버린다.        */
+struct Slot { std::atomic<uint64_t> seq{0}; Span s{}; };
+
+struct Ring {
+    Ring(size_t n, uint32_t t) : slots(new Slot[n]), size(n), tid(t) {}
+    std::unique_ptr<Slot[]> slots;
+    size_t   size;
+    uint32_t tid;                                       // 이 스레드의 트랙 번호
+    std::atomic<uint64_t> head{0};
+
+    void push(const Span& sp) {
+        uint64_t h = head.load(std::memory_order_relaxed);
+        Slot& sl = slots[h % size];
+        sl.seq.store(2*h + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        sl.s = sp;
+        sl.seq.store(2*h + 2, std::memory_order_release);
+        head.store(h + 1, std::memory_order_release);
+    }
+    void collect(int64_t from_us, std::vector<Span>& out) const {
+        uint64_t h = head.load(std::memory_order_acquire);
+        for (uint64_t i = h > size ? h - size : 0; i < h; ++i) {
+            const Slot& sl = slots[i % size];
+            uint64_t a = sl.seq.load(std::memory_order_acquire);
+            if (a != 2*i + 2) continue;
+            Span c = sl.s;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (sl.seq.load(std::memory_order_relaxed) != a) continue;
+            if (c.ts_us + c.dur_us >= from_us) out.push_back(c);
+        }
+    }
+};
+
+struct State {
+    std::atomic<bool> on{false};
+    size_t slots = 0;
+    std::mutex m;
+    std::vector<std::unique_ptr<Ring>> rings;           // 스레드가 끝나도 덤프용으로 남긴다
+    std::map<uint32_t, std::string> names;              // 트랙 번호 → 이름
+    std::atomic<uint32_t> next_track{1};
+};
+inline State& state() { static State s; return s; }
+
+inline void enable(size_t slots_per_thread) {
+    state().slots = slots_per_thread;
+    state().on.store(true, std::memory_order_release);
+}
+inline bool enabled() { return state().on.load(std::memory_order_relaxed); }
+
+inline Ring& ring() {
+    thread_local Ring* r = [] {
+        State& st = state();
+        auto p = std::make_unique<Ring>(st.slots, st.next_track++);
+        std::lock_guard<std::mutex> lk(st.m);
+        st.names.emplace(p->tid, "thread " + std::to_string(p->tid));
+        st.rings.push_back(std::move(p));
+        return st.rings.back().get();
+    }();
+    return *r;
+}
+
+// 호출 스레드 트랙 이름 (스레드 시작 시 한 번)
+inline void nameThread(const std::string& name) {
+    if (!enabled()) return;
+    uint32_t t = ring().tid;
+    std::lock_guard<std::mutex> lk(state().m);
+    state().names[t] = name;
+}
+
+// 스트림처럼 여러 스레드를 거치는 흐름의 트랙. 꺼져 있으면 0
+inline uint32_t newTrack(const std::string& name) {
+    if (!enabled()) return 0;
+    uint32_t t = state().next_track++;
+    std::lock_guard<std::mutex> lk(state().m);
+    state().names[t] = name;
+    return t;
+}
+
+inline void span(const char* name, uint32_t track, uint64_t frame, int64_t t0_us, int64_t t1_us) {
+    if (!enabled()) return;
+    Ring& r = ring();
+    r.push({name, t0_us, std::max<int64_t>(0, t1_us - t0_us), track ? track : r.tid, (uint32_t)frame});
+}
+
+struct Scope {
+    const char* name; uint32_t track; uint64_t frame; int64_t t0;
+    Scope(const char* n, uint32_t tr = 0, uint64_t f = 0)
+        : name(n), track(tr), frame(f), t0(enabled() ? nowUs() : 0) {}
+    ~Scope() { if (t0) span(name, track, frame, t0, nowUs()); }
+};
+
+/* ───── 다른 Chrome trace 이벤트 배열 합치기 (ORT 프로파일 등) ─────────────
+ * json 은 [{...},{...}] 형태. 최상위 객체마다 "ts" 에 shift_us 를 더하고
+ * from_us 이전 이벤트는 버린다. 결과는 객체 텍스트 그대로 out 에 추가.     */
+inline void appendEvents(const std::string& json, int64_t shift_us, int64_t from_us,
+                         std::vector<std::string>& out)
+{
+    int depth = 0; bool str = false, esc = false; size_t beg = 0;
+    for (size_t i = 0; i < json.size(); ++i) {
+        char c = json[i];
+        if (str) { if (esc) esc = false; else if (c == '\\') esc = true; else if (c == '"') str = false; continue; }
+        if (c == '"') { str = true; continue; }
+        if (c == '{' && depth++ == 0) beg = i;
+        if (c == '}' && --depth == 0) {
+            std::string ev = json.substr(beg, i - beg + 1);
+            size_t k = ev.find("\"ts\"");
+            if (k == std::string::npos) continue;
+            k = ev.find(':', k); if (k == std::string::npos) continue;
+            size_t e = k + 1;
+            while (e < ev.size() && (ev[e] == ' ')) ++e;
+            char* end = nullptr;
+            int64_t ts = std::strtoll(ev.c_str() + e, &end, 10) + shift_us;
+            if (ts < from_us) continue;
+            ev.replace(e, end - (ev.c_str() + e), std::to_string(ts));
+            out.push_back(std::move(ev));
+        }
+    }
+}
+
+// 마지막 window_sec 초를 path 에 기록. extra 는 그대로 넣을 이벤트 객체들. 기록한 구간 수, 실패 시 -1
+inline long dump(const std::string& path, int window_sec, const std::vector<std::string>& extra = {})
+{
+    State& st = state();
+    const int64_t from = nowUs() - (int64_t)window_sec * 1000000;
+    std::vector<Span> spans; std::map<uint32_t, std::string> names;
+    {   std::lock_guard<std::mutex> lk(st.m);
+        for (auto& r : st.rings) r->collect(from, spans);
+        names = st.names;
+    }
+    std::sort(spans.begin(), spans.end(), [](const Span& a, const Span& b){ return a.ts_us < b.ts_us; });
+
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return -1;
+    const int pid = (int)getpid();
+    std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    auto sep = [&]{ if (!first) std::fputs(",\n", f); first = false; };
+    for (auto& [t, n] : names) {
+        sep();
+        std::string esc;
+        for (char c : n) { if (c == '"' || c == '\\') esc += '\\'; esc += c; }
+        std::fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":\"%s\"}}",
+                     pid, t, esc.c_str());
+    }
+    for (const Span& s : spans) {
+        sep();
+        std::fprintf(f, "{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%lld,\"dur\":%lld,\"pid\":%d,\"tid\":%u,\"args\":{\"frame\":%u}}",
+                     s.name, (long long)s.ts_us, (long long)s.dur_us, pid, s.track, s.frame);
+    }
+    for (const auto& ev : extra) { sep(); std::fputs(ev.c_str(), f); }
+    std::fprintf(f, "\n]}\n");
+    bool ok = std::fclose(f) == 0;
+    return ok ? (long)spans.size() : -1;
+}
+
+}  // namespace ftrace
@@ -0,0 +1,151 @@
+// huge_alloc.hpp
+// 큰 버퍼(입력 텐서, ORT 텐서, 디코드한 프레임)를 2MB huge page 로 잡아 dTLB 미스를 줄인다.
+//   huge::setMode(huge::Mode::Auto);           // 명시적(hugetlbfs 풀) → THP(madvise) → 일반 페이지
+//   huge::Vector<float> blob(n);               // std::vector 와 같음
+//   void* p = huge::alloc(bytes); huge::free(p);
+// HUGE_MIN 보다 작은 요청은 64B 정렬 malloc (TLB 이득이 없고 2MB 씩 낭비되므로).
+// Explicit 은 hugetlbfs 풀만 쓴다: 풀이 비면 THP 로 넘어가지 않고 일반 페이지 (fallbacks 로 집계).
+// 해제된 큰 블록은 크기별로 캐시해 두고 재사용한다 (매번 mmap·0 채우기 페이지 폴트 방지).
+#pragma once
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace huge {
+
+enum class Mode { Off, Auto, Explicit, Thp };
+
+constexpr size_t PAGE      = 2u << 20;
+constexpr size_t HUGE_MIN  = 1u << 20;            // 이보다 작으면 일반 페이지
+constexpr size_t HDR       = 64;                  // 블록 앞 머리 (정렬 유지)
+constexpr size_t CACHE_MAX = 512u << 20;          // 재사용 캐시 상한
+
+struct Stats {
+    std::atomic<size_t> explicit_bytes{0}, thp_bytes{0}, fallbacks{0};
+    std::atomic<size_t> hugetlb_misses{0};        // MAP_HUGETLB 실패 (풀 없음·소진), Auto 면 THP 로 감
+};
+
+namespace detail {
+enum Kind : uint32_t { Small, Mapped };
+struct Header { void* base; size_t len; uint32_t kind, via_thp; };
+static_assert(sizeof(Header) <= HDR, "header too large");
+
+struct Cache {
+    std::mutex m;
+    std::multimap<size_t, Header*> free;          // len → 블록
+    size_t bytes = 0;
+};
+inline Cache& cache() { static Cache c; return c; }
+inline std::atomic<Mode>& mode() { static std::atomic<Mode> m{Mode::Off}; return m; }
+inline Stats& stats() { static Stats s; return s; }
+
+// len 바이트 (PAGE 배수) 를 huge page 로. 실패하면 nullptr
+inline Header* map(size_t len, Mode m) {
+    if (m == Mode::Auto || m == Mode::Explicit) {
+        void* b = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (b != MAP_FAILED) return new (b) Header{b, len, Mapped, 0};
+        if (stats().hugetlb_misses++ == 0)
+            std::cerr << "⚠️  huge: MAP_HUGETLB failed (/proc/sys/vm/nr_hugepages 풀이 비었음), "
+                      << (m == Mode::Explicit ? "normal pages" : "falling back to THP") << '\n';
+        if (m == Mode::Explicit) return nullptr;          // 조용히 Auto 가 되지 않게
+    }
+    // THP: 2MB 경계에 맞춰 잡고 madvise (남는 앞뒤는 돌려준다)
+    void* raw = mmap(nullptr, len + PAGE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return nullptr;
+    uintptr_t a = ((uintptr_t)raw + PAGE - 1) & ~(uintptr_t)(PAGE - 1);
+    if (a > (uintptr_t)raw) munmap(raw, a - (uintptr_t)raw);
+    munmap((void*)(a + len), (uintptr_t)raw + len + PAGE - (a + len));
+    if (madvise((void*)a, len, MADV_HUGEPAGE) != 0) { munmap((void*)a, len); return nullptr; }
+    return new ((void*)a) Header{(void*)a, len, Mapped, 1};
+}
+}  // namespace detail
+
+using detail::stats;
+inline void setMode(Mode m) { detail::mode() = m; }
+inline Mode getMode() { return detail::mode(); }
+
+inline void* alloc(size_t n) {
+    using namespace detail;
+    const Mode m = mode();
+    if (m != Mode::Off && n >= HUGE_MIN) {
+        const size_t len = (n + HDR + PAGE - 1) / PAGE * PAGE;
+        Header* h = nullptr;
+        {   Cache& c = cache(); std::lock_guard<std::mutex> lk(c.m);
+            auto it = c.free.find(len);
+            if (it != c.free.end()) { h = it->second; c.bytes -= len; c.free.erase(it); }
+        }
+        if (!h && (h = map(len, m)))
+            (h->via_thp ? stats().thp_bytes : stats().explicit_bytes) += len;
+        if (h) return (char*)h + HDR;
+        ++stats().fallbacks;                      // huge page 를 못 잡으면 일반 페이지로
+    }
+    void* b = std::aligned_alloc(HDR, (n + HDR + HDR - 1) / HDR * HDR);
+    if (!b) return nullptr;
+    new (b) Header{b, 0, Small, 0};
+    return (char*)b + HDR;
+}
+
+inline void free(void* p) {
+    using namespace detail;
+    if (!p) return;
+    Header* h = (Header*)((char*)p - HDR);
+    if (h->kind == Small) { std::free(h->base); return; }
+    {   Cache& c = cache(); std::lock_guard<std::mutex> lk(c.m);
+        if (c.bytes + h->len <= CACHE_MAX) { c.bytes += h->len; c.free.emplace(h->len, h); return; }
+    }
+    munmap(h->base, h->len);
+}
+
+template <class T>
+struct Allocator {
+    using value_type = T;
+    Allocator() = default;
+    template <class U> Allocator(const Allocator<U>&) noexcept {}
+    T* allocate(size_t n) {
+        void* p = huge::alloc(n * sizeof(T));
+        if (!p) throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+    void deallocate(T* p, size_t) noexcept { huge::free(p); }
+    template <class U> bool operator==(const Allocator<U>&) const noexcept { return true; }
+    template <class U> bool operator!=(const Allocator<U>&) const noexcept { return false; }
+};
+template <class T> using Vector = std::vector<T, Allocator<T>>;
+
+/* ───── dTLB 읽기 미스 카운터 (--hugebench) ─────────────────────────────
+ * perf_event_open 이 막혀 있으면 (컨테이너, perf_event_paranoid) ok() == false. */
+class TlbCounter {
+public:
+    TlbCounter() {
+        perf_event_attr pe{};
+        pe.type = PERF_TYPE_HW_CACHE; pe.size = sizeof(pe);
+        pe.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                  | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        pe.disabled = 1; pe.exclude_kernel = 1; pe.exclude_hv = 1;
+        fd_ = (int)syscall(SYS_perf_event_open, &pe, 0, -1, -1, 0);
+    }
+    ~TlbCounter() { if (fd_ >= 0) close(fd_); }
+    bool ok() const { return fd_ >= 0; }
+    void start() { if (fd_ >= 0) { ioctl(fd_, PERF_EVENT_IOC_RESET, 0); ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0); } }
+    uint64_t stop() {
+        uint64_t v = 0;
+        if (fd_ >= 0) { ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0); if (read(fd_, &v, sizeof(v)) != sizeof(v)) v = 0; }
+        return v;
+    }
+private:
+    int fd_ = -1;
+};
+
+}  // namespace huge
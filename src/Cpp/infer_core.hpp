@@ -0,0 +1,243 @@
+// infer_core.hpp
+// 모델 입출력 형태, 전처리(레터박스 · uint8 입력 · 모자이크), 후처리(디코드 + NMS), 결과 직렬화.
+// 서버·배치·검증 경로가 모두 쓴다. 모델 형태 값(dyn_input, out_ch …)은 main 이 모델을 연 뒤 한 번 채운다.
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <opencv2/opencv.hpp>
+
+#include "det_log.hpp"
+#include "fast_log.hpp"
+
+constexpr int   INPUT_W = 640, INPUT_H = 640;    // 기본(최대) 입력 크기
+constexpr int   STRIDE = 32, MIN_IMGSZ = 160;     // 동적 입력 모델의 해상도 단위·하한
+constexpr int   NUM_CLASSES = 80;
+//constexpr float CONF_THR = 0.35f, NMS_THR = 0.45f;
+constexpr float CONF_THR = 0.35f, NMS_THR = 0.45f;
+
+using Clock = std::chrono::steady_clock;
+
+/* ───── ORT 입력·출력 이름 (수명 보장, 모든 워커 공유) ──────────────────── */
+inline std::vector<std::string>  in_strs,  out_strs;
+inline std::vector<const char*>  in_names, out_names;
+
+/* ───── 모델 입력 형태 ────────────────────────────────────────────────────
+ * 공간축(H,W)이 고정된 모델은 항상 model_in 으로, 동적 축 모델은 프레임
+ * 비율에 맞춘 stride 배수 직사각형으로 추론한다 (16:9 → 640×384).          */
+inline bool     dyn_input = false;
+inline bool     u8_input  = false;                // uint8 [N,H,W,3] BGR 입력 (add_preproc.py 로 변환한 모델)
+inline cv::Size model_in{INPUT_W, INPUT_H};
+inline int64_t  out_ch = 4+NUM_CLASSES;      // 출력 [1,C,N] 의 C
+inline int64_t  out_n  = -1;                 // 출력 N (-1 = 입력 크기에 따라 결정)
+inline int      e2e_rank = 0;                // NMS 내장 모델: 출력 [K,6]=2, [B,K,6]=3 (0 = 원시 출력)
+inline int      mosaic_grid = 0;             // --mosaic=G : 작은 프레임을 G×G 칸 캔버스 하나로 (0 = 끔)
+inline uint64_t model_id = 0;                // 모델 파일 내용 해시 (결과 캐시 키)
+
+/* ───── 클래스 필터 (스트림별) ───────────────────────────────────────────
+ * ids 에 있는 클래스 채널만 argmax 에 참여하고, thr 로 클래스별 신뢰도를 자른다. */
+struct ClassFilter {
+    std::vector<int>   ids;
+    std::vector<float> thr;
+    float              min_thr = CONF_THR;      // 사전 컷·NMS 용 (ids 중 최소 thr)
+    ClassFilter() : thr(NUM_CLASSES, CONF_THR) { for(int c=0;c<NUM_CLASSES;++c) ids.push_back(c); }
+};
+using FilterPtr = std::shared_ptr<const ClassFilter>;
+
+/* ───── 검출 결과 ─────────────────────────────────────────────────────── */
+struct Det { cv::Rect box; int cls; float score; };
+struct Result {
+    std::vector<Det> dets;
+    std::string      text = "[]";              // 응답 한 줄 (serialize(dets))
+};
+
+inline cv::Size inputShape(const cv::Size& frame, int imgsz)
+{
+    if(!dyn_input) return model_in;
+    float r = imgsz / (float)std::max(frame.width, frame.height);
+    auto up = [](float v){ return std::max(STRIDE, (int)std::ceil(v/STRIDE)*STRIDE); };
+    return { up(frame.width*r), up(frame.height*r) };
+}
+
+// 앵커 수: 고정 출력이면 모델 값, 아니면 stride 8/16/32 격자 셀 수의 합
+inline int64_t anchorCount(const cv::Size& in_sz)
+{
+    if(out_n>0) return out_n;
+    int64_t n=0;
+    for(int s: {8,16,32}) n += (int64_t)(in_sz.width/s)*(in_sz.height/s);
+    return n;
+}
+
+/* ───── 전처리 (호출자 소유 blob, CHW 로 바로 split) ─────────────────────── */
+// BGR uint8 캔버스 → RGB 0~1 float CHW
+inline void blobFromCanvas(cv::Mat& canvas, float* blob)
+{
+    const int IH = canvas.rows, IW = canvas.cols;
+    cv::cvtColor(canvas, canvas, cv::COLOR_BGR2RGB);
+    canvas.convertTo(canvas, CV_32F, 1.0/255.0);
+
+    std::vector<cv::Mat> ch;
+    for (int i = 0; i < 3; ++i) ch.emplace_back(IH, IW, CV_32F, blob+(size_t)i*IH*IW);
+    cv::split(canvas, ch);                           // 이미 할당된 평면에 그대로 기록
+}
+
+inline void preprocess(const cv::Mat& src,
+                const cv::Size& in_sz,
+                float* blob,
+                float& scale)
+{
+    const int IW = in_sz.width, IH = in_sz.height;
+    int w = src.cols, h = src.rows;
+    scale = std::min(IW/(float)w, IH/(float)h);
+    int nw = std::min(IW, int(w * scale)), nh = std::min(IH, int(h * scale));
+
+    cv::Mat canvas(IH, IW, CV_8UC3, cv::Scalar(114,114,114));
+    cv::Mat roi = canvas(cv::Rect(0,0,nw,nh));
+    if (nw == w && nh == h) src.copyTo(roi);         // 클라이언트가 맞춰 보낸 프레임 (fit): 리사이즈 없음
+    else cv::resize(src, roi, {nw, nh});
+    blobFromCanvas(canvas, blob);
+}
+
+// uint8 입력 모델용: 레터박스 캔버스(BGR, HWC)를 dst 에 바로 그린다. 변환·정규화는 그래프 안에서.
+inline void preprocessU8(const cv::Mat& src, const cv::Size& in_sz, uint8_t* dst, float& scale)
+{
+    const int IW = in_sz.width, IH = in_sz.height;
+    scale = std::min(IW/(float)src.cols, IH/(float)src.rows);
+    int nw = std::min(IW, int(src.cols * scale)), nh = std::min(IH, int(src.rows * scale));
+
+    cv::Mat canvas(IH, IW, CV_8UC3, dst);
+    canvas.setTo(cv::Scalar(114,114,114));
+    cv::Mat roi = canvas(cv::Rect(0,0,nw,nh));
+    if (nw == src.cols && nh == src.rows) src.copyTo(roi);
+    else cv::resize(src, roi, {nw, nh});             // 크기가 같으므로 캔버스 위에 그대로 기록
+}
+
+/* ───── 모자이크 (--mosaic=G) ─────────────────────────────────────────────
+ * 칸 크기 이하의 작은 프레임 여러 장을 G×G 칸 캔버스 하나에 붙여 한 번에 추론한다.
+ * 결과는 중심이 그 프레임 칸 안에 있는 후보만, 칸 그림 영역으로 잘라 스트림 좌표로 되돌린다.
+ * 잘려서 절반 넘게 사라지는 박스(옆 칸에 걸친 것)는 버린다.                      */
+inline cv::Size mosaicCanvas() { return dyn_input ? cv::Size(INPUT_W, INPUT_H) : model_in; }
+inline cv::Size mosaicCell()   { auto c = mosaicCanvas(); return { c.width/mosaic_grid, c.height/mosaic_grid }; }
+
+// 칸 k 왼쪽 위에 k 번째 프레임을 칸에 맞게 붙인다. cells[k] = 그림 영역 (캔버스 좌표)
+inline void preprocessMosaic(const std::vector<cv::Mat>& imgs, const cv::Size& in_sz,
+                      float* blob, uint8_t* blob8,            // u8_input 이면 blob8 에 직접
+                      std::vector<float>& scale, std::vector<cv::Rect>& cells)
+{
+    const cv::Size cs = mosaicCell();
+    cv::Mat canvas = blob8 ? cv::Mat(in_sz.height, in_sz.width, CV_8UC3, blob8)
+                           : cv::Mat(in_sz.height, in_sz.width, CV_8UC3);
+    canvas.setTo(cv::Scalar(114,114,114));
+    for (size_t k = 0; k < imgs.size(); ++k) {
+        const cv::Mat& src = imgs[k];
+        scale[k] = std::min(cs.width/(float)src.cols, cs.height/(float)src.rows);
+        int nw = std::min(cs.width, int(src.cols * scale[k])), nh = std::min(cs.height, int(src.rows * scale[k]));
+        cells[k] = cv::Rect((int)(k % mosaic_grid) * cs.width, (int)(k / mosaic_grid) * cs.height, nw, nh);
+        cv::Mat roi = canvas(cells[k]);
+        if (nw == src.cols && nh == src.rows) src.copyTo(roi);
+        else cv::resize(src, roi, {nw, nh});
+    }
+    if (!blob8) blobFromCanvas(canvas, blob);
+}
+
+// 모자이크 칸 기준으로 박스(캔버스 좌표 x1,y1,x2,y2)를 바꾼다. cell 이 비어 있으면 그대로.
+inline bool cellLocal(float& x1, float& y1, float& x2, float& y2, const cv::Rect& cell)
+{
+    if (cell.empty()) return true;
+    float cx = (x1 + x2) / 2.f, cy = (y1 + y2) / 2.f;
+    if (cx < cell.x || cy < cell.y || cx >= cell.x + cell.width || cy >= cell.y + cell.height) return false;
+    float a = (x2 - x1) * (y2 - y1);
+    x1 = std::max(x1, (float)cell.x);               x1 -= cell.x;
+    y1 = std::max(y1, (float)cell.y);               y1 -= cell.y;
+    x2 = std::min(x2, (float)(cell.x + cell.width)) - cell.x;
+    y2 = std::min(y2, (float)(cell.y + cell.height)) - cell.y;
+    return (x2 - x1) * (y2 - y1) >= 0.5f * a;
+}
+
+/* ───── 후처리 (NMS + 클래스라벨) ───────────────────────────────────────
+ * YOLOv8 출력 [1,4+C,N]: cx,cy,w,h 다음 채널이 바로 클래스 점수 (그래프 안에서 이미 sigmoid,
+ * objectness 채널 없음). C = out_ch-4 라서 모델에 없는 클래스 id 는 건너뛴다.      */
+inline std::vector<Det> postprocess(const float* p, int N,       // 출력 버퍼 [1,4+C,N]
+                        float scale, const cv::Size& in_sz,
+                        const ClassFilter& f, cv::Point off,  // off = ROI 좌상단
+                        const cv::Rect& cell = cv::Rect())   // 모자이크 칸 (in_sz 는 칸 크기)
+{
+    std::vector<cv::Rect> boxes; std::vector<float> scores; std::vector<int> cls;
+    const int nc = (int)out_ch - 4;
+    for (int i = 0; i < N; ++i) {
+        if (!cell.empty() && !cell.contains(cv::Point((int)p[i], (int)p[N + i]))) continue;   // 다른 칸
+
+        /* ── 클래스 선택 (허용된 채널만) ────── */
+        float conf = 0.f; int best_id = -1;
+        for (int c : f.ids) {
+            if (c >= nc) continue;
+            float v = p[(4 + c)*N + i];
+            if (v > conf) { conf = v; best_id = c; }
+        }
+        if (best_id < 0 || conf < f.thr[best_id]) continue;   // ① 점수 컷 (클래스별)
+
+        /* ── BBox 좌표 복원 ─────────────────── */
+        float cx = p[0*N + i], cy = p[1*N + i];
+        float bw = p[2*N + i], bh = p[3*N + i];
+        float bx1 = cx - bw/2.f, by1 = cy - bh/2.f, bx2 = cx + bw/2.f, by2 = cy + bh/2.f;
+        if (!cellLocal(bx1, by1, bx2, by2, cell)) continue;
+        bw = bx2 - bx1; bh = by2 - by1;
+        float x1 = bx1 / scale + off.x;
+        float y1 = by1 / scale + off.y;
+
+        /* ── ② 면적 필터 ────────────────────── */
+        float area = (bw * bh) / in_sz.area();          // 상대 면적 (0~1)
+        if (area < 0.0005f) // 0.05 % 미만은 스킵
+            continue;
+
+        /* ── 통과 ⇒ push_back ──────────────── */
+        boxes.emplace_back(cv::Rect(round(x1), round(y1), round(bw/scale), round(bh/scale)));
+        scores.emplace_back(conf);
+        cls.emplace_back(best_id);
+        FLOG_EVERY_N(FLOG_LV_INFO, 256, "pred {} cls={} conf={}", i, best_id, conf);   // 후보 256개에 1줄 (운영에서도 켜 둠)
+    }
+    std::vector<int> keep; cv::dnn::NMSBoxes(boxes,scores,f.min_thr,NMS_THR,keep);
+
+    std::vector<Det> dets; dets.reserve(keep.size());
+    for(int i: keep) dets.push_back({boxes[i],cls[i],scores[i]});
+    return dets;
+}
+
+/* ───── 결과 직렬화: "[x,y,w,h,cls,...]" ──────────────────────────────── */
+inline std::string serialize(const std::vector<Det>& dets)
+{
+    std::ostringstream ss; ss<<'[';
+    for(size_t k=0;k<dets.size();++k){
+        const auto& r=dets[k].box;
+        ss<<r.x<<','<<r.y<<','<<r.width<<','<<r.height<<','<<dets[k].cls;
+        if(k+1<dets.size()) ss<<',';
+    }
+    ss<<']'; return ss.str();
+}
+
+/* ───── 서버측 그리기 (박스 + 클래스/점수 라벨) ───────────────────────── */
+inline void drawDetections(cv::Mat& frame, const std::vector<Det>& dets)
+{
+    static const cv::Scalar PALETTE[] = {{0,255,0},{255,128,0},{0,128,255},{255,0,255},{0,255,255},{255,255,0}};
+    for(const auto& d: dets){
+        const cv::Scalar& col=PALETTE[d.cls % 6];
+        cv::rectangle(frame,d.box,col,2);
+        char label[32]; std::snprintf(label,sizeof(label),"%d %.2f",d.cls,d.score);
+        cv::putText(frame,label,{d.box.x,std::max(12,d.box.y-4)},cv::FONT_HERSHEY_SIMPLEX,0.6,col,2,cv::LINE_AA);
+    }
+}
+
+inline std::vector<DetRow> toRows(uint64_t frame_id, int64_t ts_us, const std::vector<Det>& dets)
+{
+    std::vector<DetRow> rows; rows.reserve(dets.size());
+    for(const auto& d: dets)
+        rows.push_back({frame_id,ts_us,d.box.x,d.box.y,d.box.width,d.box.height,d.cls,d.score,-1});
+    return rows;
+}
@@ -0,0 +1,342 @@
+// infer_sched.hpp
+// 추론 스케줄러(priority tier → EDF, 같은 형태끼리 배치), 형태별 IoBinding 슬롯, 추론 워커,
+// CPU 작업 풀, NUMA 도메인(노드마다 세션·스케줄러·워커). 작업은 Job 으로 넣고 결과는
+// promise 또는 done 콜백(코루틴 재개)으로 받는다.
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <queue>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include <onnxruntime_cxx_api.h>
+
+#include "infer_core.hpp"
+#include "co_loop.hpp"
+#include "frame_trace.hpp"
+#include "huge_alloc.hpp"
+
+constexpr int      NUM_TIERS   = 3;            // 0 = 안전(최우선) … 2 = 벌크 분석
+
+/* ───── 추론 스케줄러 (priority tier → EDF) ──────────────────────────────
+ * 높은 tier(작은 숫자)가 항상 먼저, 같은 tier 안에서는 데드라인이 빠른 순.
+ * 상위 tier 를 지키기 위해 하위 tier 를 먼저 포기한다:
+ *   - 예상 추론시간 안에 데드라인을 못 맞출 하위 tier 프레임은 버린다.
+ *   - tier 0 가 아슬아슬하게 끝났다면 잠시 동안 하위 tier 를 격프레임 스킵하고,
+ *     남은 프레임은 절반 해상도로 추론한다 (동적 입력 모델).                    */
+struct Job {
+    int               tier;
+    Clock::time_point deadline;        // 데드라인 없으면 time_point::max()
+    uint64_t          seq;             // 전역 도착 순서 (동률 처리)
+    uint64_t          frame_no;        // 스트림 내 프레임 번호 (격프레임 스킵)
+    cv::Point         off;             // ROI 좌상단 (결과 좌표 복원)
+    FilterPtr         filter;          // 스트림 클래스 필터
+    int               imgsz;           // 스트림 해상도 프로파일
+    bool              degraded=false;  // 스케줄러가 해상도를 낮추라고 표시
+    bool              cacheable=false; // 정상 해상도로 추론 완료 (결과 캐시 가능)
+    cv::Mat           img;
+    std::promise<Result> result;
+    std::function<void()> done;        // 결과가 정해진 뒤 호출 (코루틴 재개용, 없으면 future 로 대기)
+    float             pre_scale=1.f;   // 클라이언트가 줄여 보낸 비율 (결과는 원본 좌표로 복원)
+    uint32_t          track=0;         // 트레이스 트랙 (--trace, 0 = 기록 안 함)
+    uint64_t          trace_frame=0;
+    int64_t           queued_us=0;
+};
+using JobPtr = std::shared_ptr<Job>;
+
+inline void complete(Job& j, Result r)
+{
+    j.result.set_value(std::move(r));
+    if(j.done) j.done();
+}
+
+// 작업의 실제 입력 형태 (해상도 프로파일, 스케줄러의 해상도 강등 반영)
+inline cv::Size jobShape(const Job& j)
+{
+    int imgsz = j.degraded ? std::max(MIN_IMGSZ, j.imgsz/2/STRIDE*STRIDE) : j.imgsz;
+    return inputShape(j.img.size(), imgsz);
+}
+
+// 모자이크 칸에 들어가는 작은 프레임인가
+inline bool mosaicFits(const Job& j)
+{
+    if(mosaic_grid<2) return false;
+    const cv::Size cs=mosaicCell();
+    return j.img.cols<=cs.width && j.img.rows<=cs.height;
+}
+
+class Scheduler {
+public:
+    void submit(JobPtr j){
+        if(j->track) j->queued_us=ftrace::nowUs();
+        { std::lock_guard<std::mutex> lk(m_); j->seq=seq_++; q_.push(std::move(j)); }
+        cv_.notify_one();
+    }
+
+    // 실행할 작업을 최대 max_batch 개 꺼낸다. 두 번째부터는 큐 맨 앞이 같은 tier·
+    // 같은 입력 형태일 때만 묶는다. 모자이크 대상이면 max_batch 대신 칸 수만큼. 포기할 하위 tier 작업은 여기서 빈 결과로 응답.
+    std::vector<JobPtr> popBatch(size_t max_batch){
+        std::vector<JobPtr> batch;
+        std::unique_lock<std::mutex> lk(m_);
+        while(batch.empty()){
+            cv_.wait(lk,[&]{ return !q_.empty(); });
+            JobPtr j=q_.top(); q_.pop();
+            if(admit(*j)) batch.push_back(std::move(j));
+        }
+        if(mosaicFits(*batch[0])){                 // 모자이크: 같은 tier 의 작은 프레임을 칸 수만큼
+            while(batch.size()<(size_t)(mosaic_grid*mosaic_grid) && !q_.empty() && q_.top()->tier==batch[0]->tier){
+                JobPtr j=q_.top();
+                if(!admit(*j)){ q_.pop(); continue; }
+                if(!mosaicFits(*j)) break;
+                q_.pop(); batch.push_back(std::move(j));
+            }
+            return batch;
+        }
+        const cv::Size shape=jobShape(*batch[0]);
+        while(batch.size()<max_batch && !q_.empty() && q_.top()->tier==batch[0]->tier){
+            JobPtr j=q_.top();
+            if(!admit(*j)){ q_.pop(); continue; }
+            if(jobShape(*j)!=shape) break;
+            q_.pop(); batch.push_back(std::move(j));
+        }
+        return batch;
+    }
+
+    // 워커가 배치 하나를 마칠 때마다 호출: 추론시간 EWMA 와 tier 0 여유시간 갱신.
+    // EWMA 는 배치당 한 번 (작업마다 넣으면 큰 배치의 시간이 B 배로 반영된다)
+    void finished(const std::vector<JobPtr>& js, Clock::duration took){
+        auto now=Clock::now();
+        std::lock_guard<std::mutex> lk(m_);
+        double ms=std::chrono::duration<double,std::milli>(took).count();
+        est_ms_=0.9*est_ms_+0.1*ms;
+        for(const auto& j: js){
+            if(now>j->deadline) ++missed_[j->tier];
+            if(j->tier==0 && j->deadline!=Clock::time_point::max()
+               && j->deadline-now < std::chrono::duration<double,std::milli>(est_ms_))
+                pressure_until_=now+std::chrono::milliseconds(500);
+        }
+    }
+
+    void report(std::ostream& os){
+        std::lock_guard<std::mutex> lk(m_);
+        os<<"🟡 est "<<est_ms_<<"ms";
+        for(int t=0;t<NUM_TIERS;++t) os<<" | tier"<<t<<" drop="<<dropped_[t]<<" miss="<<missed_[t];
+        os<<'\n';
+    }
+
+private:
+    // tier 0 는 항상 실행. 하위 tier 는 버리거나(빈 결과 응답) 해상도 강등 표시.
+    bool admit(Job& j){
+        if(j.tier==0) return true;
+        if(!shouldDrop(j)){ j.degraded = Clock::now()<pressure_until_; return true; }
+        ++dropped_[j.tier];
+        complete(j,Result{});
+        return false;
+    }
+
+    bool shouldDrop(const Job& j) const {
+        auto now=Clock::now();
+        if(now+std::chrono::duration<double,std::milli>(est_ms_) > j.deadline) return true;
+        return now<pressure_until_ && (j.frame_no&1);
+    }
+
+    struct Later {
+        bool operator()(const JobPtr& a,const JobPtr& b) const {
+            if(a->tier!=b->tier)         return a->tier>b->tier;
+            if(a->deadline!=b->deadline) return a->deadline>b->deadline;
+            return a->seq>b->seq;
+        }
+    };
+    std::mutex m_; std::condition_variable cv_;
+    std::priority_queue<JobPtr,std::vector<JobPtr>,Later> q_;
+    uint64_t seq_=0;
+    double   est_ms_=30.0;
+    Clock::time_point pressure_until_{};
+    uint64_t dropped_[NUM_TIERS]{}, missed_[NUM_TIERS]{};
+};
+
+/* ───── 입력 형태별 IoBinding (워커 소유) ────────────────────────────────
+ * 입력·출력 텐서를 워커 버퍼에 한 번만 바인딩해 두고 매 프레임 재사용한다.
+ * → session.Run 경계에서 출력 할당·이름 조회·MemoryInfo 생성이 없다.
+ * 배치 B 는 같은 형태 프레임 B 장을 [B,3,H,W] 로 이어 붙인 것.               */
+// NMS 가 그래프 안에 있는 모델 (add_nms.py, yolo export nms=True)
+// 행 = x1,y1,x2,y2,score,cls (입력 캔버스 좌표). 고정 K 모델의 빈 행은 score 0.
+inline std::vector<Det> decodeE2E(const float* p, int64_t K,
+                           float scale, const cv::Size& in_sz,
+                           const ClassFilter& f, cv::Point off,
+                           const cv::Rect& cell = cv::Rect())
+{
+    std::vector<Det> dets;
+    for (int64_t i = 0; i < K; ++i, p += 6) {
+        int c = (int)p[5]; float conf = p[4];
+        if (c < 0 || c >= NUM_CLASSES || conf < f.thr[c]) continue;
+        if (std::find(f.ids.begin(), f.ids.end(), c) == f.ids.end()) continue;
+        float x1 = p[0], y1 = p[1], x2 = p[2], y2 = p[3];
+        if (!cellLocal(x1, y1, x2, y2, cell)) continue;
+        float bw = x2 - x1, bh = y2 - y1;
+        if (bw * bh / in_sz.area() < 0.0005f) continue;     // postprocess 와 같은 면적 필터
+        dets.push_back({cv::Rect(round(x1/scale + off.x), round(y1/scale + off.y),
+                                 round(bw/scale), round(bh/scale)), c, conf});
+    }
+    return dets;
+}
+
+struct ShapeSlot {
+    cv::Size           in_sz;
+    int64_t            B, N;
+    size_t             in_elems, out_elems;      // 프레임 1장당 원소 수
+    huge::Vector<float> blob, out;                // --hugepages 면 2MB 페이지
+    huge::Vector<uint8_t> blob8;                  // u8_input 일 때만 (blob 대신)
+    Ort::Value         in_t{nullptr}, out_t{nullptr};
+    std::unique_ptr<Ort::IoBinding> bind;
+
+    ShapeSlot(Ort::Session& session, Ort::MemoryInfo& mem, const cv::Size& sz, int64_t batch)
+        : in_sz(sz), B(batch), N(anchorCount(sz)),
+          in_elems((size_t)3*sz.width*sz.height), out_elems(e2e_rank ? 0 : (size_t)(out_ch*N)),
+          out(B*out_elems)
+    {
+        int64_t out_dims[3]{B,out_ch,N};
+        if(u8_input){
+            int64_t in_dims[4]{B,sz.height,sz.width,3};
+            blob8.resize(B*in_elems);
+            in_t = Ort::Value::CreateTensor<uint8_t>(mem, blob8.data(), blob8.size(), in_dims, 4);
+        }else{
+            int64_t in_dims[4]{B,3,sz.height,sz.width};
+            blob.resize(B*in_elems);
+            in_t = Ort::Value::CreateTensor<float>(mem, blob.data(), blob.size(), in_dims, 4);
+        }
+        bind  = std::make_unique<Ort::IoBinding>(session);
+        bind->BindInput (in_names[0],  in_t);
+        if(e2e_rank){                             // 검출 수가 매번 달라서 ORT 가 할당
+            bind->BindOutput(out_names[0], mem);
+            return;
+        }
+        out_t = Ort::Value::CreateTensor<float>(mem, out.data(),  out.size(),  out_dims, 3);
+        bind->BindOutput(out_names[0], out_t);
+    }
+};
+
+/* ───── 추론 워커 (세션 공유, 형태·배치별 바인딩은 워커 소유) ──────────── */
+inline void inferWorker(Ort::Session& session, Ort::MemoryInfo& mem, Scheduler& sched, int max_batch)
+{
+    std::map<std::tuple<int,int,int>,std::unique_ptr<ShapeSlot>> slots;   // (W,H,B) → slot
+    const Ort::RunOptions run_opts;
+    while(true){
+        std::vector<JobPtr> js=sched.popBatch(max_batch);
+        auto t0=Clock::now();
+        const int64_t pop_us = ftrace::enabled() ? ftrace::nowUs() : 0;
+        for(auto& j: js) if(j->track) ftrace::span("queue",j->track,j->trace_frame,j->queued_us,pop_us);
+        const uint64_t tf=js[0]->trace_frame;
+
+        const int B=(int)js.size();
+        const bool mosaic = B>1 && mosaicFits(*js[0]);   // 프레임 B장 → 캔버스 1장
+        const int  TB = mosaic ? 1 : B;                   // 텐서 배치 크기
+        cv::Size in_sz = mosaic ? mosaicCanvas() : jobShape(*js[0]);
+        auto& slot = slots[{in_sz.width, in_sz.height, TB}];
+
+        std::vector<float> scale(B,1.f);
+        std::vector<cv::Rect> cells(B);           // 모자이크: 프레임별 칸 그림 영역
+        std::vector<Ort::Value> e2e;              // e2e_rank 일 때 출력 [K,6] / [B,K,6]
+        int64_t rows=0;
+        try{
+            if(!slot) slot=std::make_unique<ShapeSlot>(session,mem,in_sz,TB);
+            {   ftrace::Scope ts("preprocess",0,tf);
+                if(mosaic){
+                    std::vector<cv::Mat> imgs; for(auto& j: js) imgs.push_back(j->img);
+                    preprocessMosaic(imgs,in_sz,slot->blob.data(),u8_input ? slot->blob8.data() : nullptr,scale,cells);
+                }else for(int k=0;k<B;++k){
+                    if(u8_input) preprocessU8(js[k]->img,in_sz,slot->blob8.data()+k*slot->in_elems,scale[k]);
+                    else         preprocess  (js[k]->img,in_sz,slot->blob.data() +k*slot->in_elems,scale[k]);
+                }
+                for(int k=0;k<B;++k) scale[k]*=js[k]->pre_scale;
+            }
+            {   ftrace::Scope ts("session.Run",0,tf);
+                session.Run(run_opts,*slot->bind);
+            }
+            if(e2e_rank){
+                e2e=slot->bind->GetOutputValues();
+                auto shp=e2e[0].GetTensorTypeAndShapeInfo().GetShape();
+                rows = shp.size()==3 ? shp[1] : shp[0];
+            }
+        }catch(const std::exception& e){                 // Ort · cv::Exception (전처리) · bad_alloc (슬롯): 워커는 분리된 스레드라 밖으로 못 던진다
+            FLOG_ERROR("Run() failed: {}", e.what());
+            slot.reset();
+            for(auto& j: js) complete(*j,Result{});
+            continue;
+        }
+
+        sched.finished(js,Clock::now()-t0);
+        ftrace::Scope ts("postprocess",0,tf);
+        for(int k=0;k<B;++k){
+            Job& j=*js[k];
+            Result res;
+            const int b = mosaic ? 0 : k;                      // 출력 텐서 안 위치
+            const cv::Size area_sz = mosaic ? cells[k].size() : in_sz;
+            try{
+                res.dets = e2e_rank
+                    ? decodeE2E(e2e[0].GetTensorData<float>()+b*rows*6,rows,scale[k],area_sz,*j.filter,j.off,cells[k])
+                    : postprocess(slot->out.data()+b*slot->out_elems,(int)slot->N,scale[k],area_sz,*j.filter,j.off,cells[k]);
+                res.text=serialize(res.dets);
+                j.cacheable=!j.degraded;
+            }catch(const std::exception& e){             // 이 작업만 빈 결과 (캐시하지 않음)
+                FLOG_ERROR("postprocess failed: {}", e.what());
+                res=Result{};
+            }
+            if(j.track) ftrace::span("infer",j.track,j.trace_frame,pop_us,ftrace::nowUs());
+            complete(j,std::move(res));
+        }
+    }
+}
+
+/* ───── CPU 작업 스레드 풀 (그리기·인코딩, 도메인별 JPEG 디코드) ───────────
+ * 추론 워커·이벤트 루프와 분리된 스레드에서 무거운 이미지 작업을 한다.
+ * init 은 각 스레드 시작 시 한 번 (NUMA 고정 등).                           */
+class TaskPool {
+public:
+    explicit TaskPool(int threads, std::function<void()> init={}){
+        for(int i=0;i<threads;++i) std::thread([this,init]{ if(init) init(); loop(); }).detach();
+    }
+    // limit 이 있으면 큐가 꽉 찼을 때 작업을 버리고 false
+    bool submit(std::function<void()> task, size_t limit=SIZE_MAX){
+        {   std::lock_guard<std::mutex> lk(m_);
+            if(q_.size()>=limit) return false;
+            q_.push(std::move(task));
+        }
+        cv_.notify_one(); return true;
+    }
+private:
+    void loop(){
+        while(true){
+            std::function<void()> task;
+            {   std::unique_lock<std::mutex> lk(m_);
+                cv_.wait(lk,[&]{ return !q_.empty(); });
+                task=std::move(q_.front()); q_.pop();
+            }
+            try{ task(); }                                // 깨진 프레임의 그리기·인코딩 실패가 풀 스레드를 죽이지 않게
+            catch(const std::exception& e){ FLOG_WARN("pool task failed: {}",e.what()); }
+        }
+    }
+    std::mutex m_; std::condition_variable cv_;
+    std::queue<std::function<void()>> q_;
+};
+
+/* ───── NUMA 도메인: 노드마다 세션·스케줄러·추론 워커 ──────────────────────
+ * 워커와 그 노드로 배정된 연결 스레드를 노드 CPU 에 고정하므로 수신 버퍼·디코드·
+ * 전처리·ORT 아레나가 모두 first-touch 로 같은 노드 메모리에 잡힌다.          */
+struct Domain {
+    int node=0; std::vector<int> cpus;
+    bool pin=false;                              // NUMA 모드일 때만 고정
+    Scheduler sched;
+    std::unique_ptr<Ort::Session> session;
+    std::unique_ptr<co::EventLoop> loop;         // 이 도메인 연결들의 코루틴이 도는 루프
+    std::unique_ptr<TaskPool> cpu;               // JPEG 디코드
+    std::atomic<int> conns{0};
+    std::atomic<bool> ort_prof{false};          // --trace-ort: ORT 프로파일러가 아직 돌고 있음
+};
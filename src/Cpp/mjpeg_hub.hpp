@@ -0,0 +1,120 @@
+// mjpeg_hub.hpp
+// 서버가 그린(annotated) 프레임을 HTTP multipart/x-mixed-replace(MJPEG) 로 내보낸다.
+// 브라우저나 VLC 로 http://<서버>:<포트>/<스트림 이름> 을 열면 된다.
+// 스트림마다 최신 JPEG 한 장만 보관하고, 느린 뷰어는 중간 프레임을 건너뛴다.
+// 채널은 publish 가 만든다: 아직 그린 프레임이 없는 이름은 404. 프레임이 VIEWER_IDLE 동안
+// 오지 않거나 뷰어가 SEND_TIMEOUT 동안 받지 않으면 뷰어 연결을 닫는다 (스레드가 영원히 묶이지 않게).
+#pragma once
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class MjpegHub {
+public:
+    static constexpr auto VIEWER_IDLE  = std::chrono::seconds(10);
+    static constexpr int  SEND_TIMEOUT = 5;       // 초 (요청 수신에도 같은 값)
+
+    using Jpeg = std::shared_ptr<const std::vector<unsigned char>>;
+
+    void publish(const std::string& name, Jpeg jpeg) {
+        Channel& ch = *channel(name, true);
+        { std::lock_guard<std::mutex> lk(ch.m); ch.jpeg = std::move(jpeg); ++ch.seq; }
+        ch.cv.notify_all();
+    }
+
+    // ip:port 에서 HTTP 뷰어를 받는 스레드를 띄운다 (ip 는 메인 소켓과 같은 주소).
+    bool listenOn(const std::string& ip, int port) {
+        int srv = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{}; addr.sin_family = AF_INET; addr.sin_port = htons(port);
+        if (inet_pton(AF_INET, ip.c_str(), &addr.sin_addr) != 1) {
+            std::cerr << "mjpeg: bad address " << ip << '\n'; close(srv); return false;
+        }
+        int yes = 1; setsockopt(srv, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        if (bind(srv, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(srv, SOMAXCONN) < 0) {
+            perror("mjpeg"); close(srv); return false;
+        }
+        std::thread([this, srv]{
+            while (true) {
+                int cli = accept(srv, nullptr, nullptr); if (cli < 0) continue;
+                std::thread(&MjpegHub::serveViewer, this, cli).detach();
+            }
+        }).detach();
+        std::cout << "🔵 MJPEG on " << ip << ':' << port << "/<stream>\n";
+        return true;
+    }
+
+private:
+    struct Channel {
+        std::mutex m; std::condition_variable cv;
+        Jpeg jpeg; uint64_t seq = 0;
+    };
+
+    // create=false 면 없는 이름은 nullptr (뷰어가 아무 경로로나 채널을 만들지 못하게)
+    Channel* channel(const std::string& name, bool create) {
+        std::lock_guard<std::mutex> lk(m_);
+        auto it = channels_.find(name);
+        if (it != channels_.end()) return it->second.get();
+        if (!create) return nullptr;
+        return (channels_[name] = std::make_unique<Channel>()).get();
+    }
+
+    static bool sendStr(int s, const std::string& str) { return sendBytes(s, str.data(), str.size()); }
+    static bool sendBytes(int s, const void* b, size_t l) {
+        const char* p = (const char*)b;
+        while (l) { ssize_t n = send(s, p, l, MSG_NOSIGNAL); if (n <= 0) return false; p += n; l -= n; }
+        return true;
+    }
+
+    void serveViewer(int cli) {
+        timeval tv{SEND_TIMEOUT, 0};
+        setsockopt(cli, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        setsockopt(cli, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        // "GET /<name> HTTP/1.1" 첫 줄만 본다
+        char req[1024]; ssize_t n = recv(cli, req, sizeof(req) - 1, 0);
+        if (n <= 0) { close(cli); return; }
+        req[n] = '\0';
+        std::string line(req), name;
+        auto a = line.find(' '), b = line.find(' ', a + 1);
+        if (a != std::string::npos && b != std::string::npos && line[a + 1] == '/')
+            name = line.substr(a + 2, b - a - 2);
+
+        Channel* chp = channel(name, false);
+        if (!chp) {
+            sendStr(cli, "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+            close(cli); return;
+        }
+        Channel& ch = *chp;
+        if (!sendStr(cli, "HTTP/1.1 200 OK\r\nCache-Control: no-cache\r\n"
+                          "Content-Type: multipart/x-mixed-replace; boundary=frame\r\n\r\n")) { close(cli); return; }
+
+        uint64_t seen = 0;
+        while (true) {
+            Jpeg jpeg;
+            {   std::unique_lock<std::mutex> lk(ch.m);
+                if (!ch.cv.wait_for(lk, VIEWER_IDLE, [&]{ return ch.seq != seen; })) break;   // 스트림이 멈춤
+                seen = ch.seq; jpeg = ch.jpeg;
+            }
+            if (!jpeg) continue;                       // 인코딩 실패한 프레임
+            std::string head = "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: "
+                             + std::to_string(jpeg->size()) + "\r\n\r\n";
+            if (!sendStr(cli, head) || !sendBytes(cli, jpeg->data(), jpeg->size()) || !sendStr(cli, "\r\n")) break;
+        }
+        close(cli);
+    }
+
+    std::mutex m_;
+    std::map<std::string, std::unique_ptr<Channel>> channels_;
+};
@@ -0,0 +1,66 @@
+// numa_topo.hpp
+// sysfs(/sys/devices/system/node) 에서 NUMA 노드별 CPU 목록을 읽고 스레드를 노드에 고정한다.
+// libnuma 없이 동작하며, 메모리는 리눅스 first-touch 정책으로 노드에 붙인다:
+// 고정된 스레드가 처음 쓰는 페이지(ORT 아레나, 수신 버퍼, 디코드 결과)는 그 노드 메모리에 잡힌다.
+#pragma once
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct NumaNode {
+    int id = 0;
+    std::vector<int> cpus;
+};
+
+// sysfs 목록 형식 (cpulist, node/online): "0-3,8-11" → {0,1,2,3,8,9,10,11}
+inline std::vector<int> parseIdList(const std::string& s)
+{
+    std::vector<int> ids;
+    std::stringstream ss(s); std::string part;
+    while (std::getline(ss, part, ',')) {
+        if (part.empty() || part == "\n") continue;
+        auto dash = part.find('-');
+        int a = std::stoi(part), b = dash == std::string::npos ? a : std::stoi(part.substr(dash + 1));
+        for (int c = a; c <= b; ++c) ids.push_back(c);
+    }
+    return ids;
+}
+
+// CPU 가 있는 노드만, 현재 프로세스에 허용된 CPU(taskset/cgroup)로 좁혀서 돌려준다.
+// NUMA 정보가 없으면 허용된 CPU 전체를 노드 0 하나로 본다.
+inline std::vector<NumaNode> numaNodes()
+{
+    cpu_set_t allowed; CPU_ZERO(&allowed);
+    sched_getaffinity(0, sizeof(allowed), &allowed);
+
+    std::vector<NumaNode> nodes;
+    std::ifstream online("/sys/devices/system/node/online");
+    std::string ids; std::getline(online, ids);
+    for (int id : parseIdList(ids)) {
+        std::ifstream f("/sys/devices/system/node/node" + std::to_string(id) + "/cpulist");
+        std::string line; std::getline(f, line);
+        NumaNode n; n.id = id;
+        for (int c : parseIdList(line)) if (c < CPU_SETSIZE && CPU_ISSET(c, &allowed)) n.cpus.push_back(c);
+        if (!n.cpus.empty()) nodes.push_back(std::move(n));
+    }
+    if (nodes.empty()) {
+        NumaNode n;
+        for (int c = 0; c < CPU_SETSIZE; ++c) if (CPU_ISSET(c, &allowed)) n.cpus.push_back(c);
+        nodes.push_back(std::move(n));
+    }
+    return nodes;
+}
+
+// 호출한 스레드를 cpus 에 고정. 이후 이 스레드가 만든 스레드도 같은 마스크를 물려받는다.
+inline bool pinThread(const std::vector<int>& cpus)
+{
+    if (cpus.empty()) return false;
+    cpu_set_t set; CPU_ZERO(&set);
+    for (int c : cpus) if (c < CPU_SETSIZE) CPU_SET(c, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
@@ -0,0 +1,106 @@
+// proc_super.hpp
+// 멀티 프로세스 슈퍼바이저 (--procs=N): 워커 프로세스 fork · 죽으면 재시작 · SIGHUP 롤링 교체.
+// 시그널은 플래그만 세우고, 워커 쪽 처리(listen 닫기, 트레이스 덤프)는 main 이 플래그를 보고 한다.
+#pragma once
+#include <poll.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+/* ───── 멀티 프로세스 (--procs=N) ─────────────────────────────────────────
+ * 슈퍼바이저가 워커 프로세스 N개를 fork 하고, 워커마다 SO_REUSEPORT 로 같은 포트를
+ * 따로 listen 한다 (연결 분배는 커널). 워커가 죽으면 같은 번호로 다시 띄우며,
+ * 그동안 나머지 워커가 포트를 계속 잡고 있다.
+ *   SIGHUP  : 워커를 하나씩 교체 (새 워커 listen 확인 → 옛 워커 SIGTERM)
+ *   SIGTERM : 전체 종료. 워커는 listen 을 닫고 진행 중인 연결이 끝날 때까지 기다린다.
+ *   SIGUSR1 : 워커들에게 전달 (트레이스 덤프)                                      */
+constexpr int READY_TIMEOUT_MS = 60000;           // 교체 시 새 워커 준비 대기 한도
+constexpr int DRAIN_SEC        = 10;              // 종료 시 연결 정리 대기 한도
+
+inline volatile sig_atomic_t sig_hup=0, sig_term=0, sig_dump=0;
+inline int ready_fd=-1;                                  // 워커 → 슈퍼바이저: listen 완료 알림
+
+inline void onSignal(int sig){ if(sig==SIGHUP) sig_hup=1; else if(sig==SIGUSR1) sig_dump=1; else sig_term=1; }
+
+// 슈퍼바이저: waitpid 를 깨우도록 SA_RESTART 없이. 워커: 연결 스레드의 recv 가 끊기지 않게 SA_RESTART.
+inline void setSignals(bool supervisor)
+{
+    struct sigaction sa{}; sa.sa_handler=onSignal; sa.sa_flags = supervisor ? 0 : SA_RESTART;
+    sigaction(SIGTERM,&sa,nullptr); sigaction(SIGINT,&sa,nullptr); sigaction(SIGUSR1,&sa,nullptr);
+    if(supervisor) sigaction(SIGHUP,&sa,nullptr);
+    else{ signal(SIGHUP,SIG_IGN); signal(SIGPIPE,SIG_IGN); }   // 준비 알림을 아무도 안 읽어도 죽지 않게
+}
+
+// 부모는 슈퍼바이저로 남아 돌아오지 않고, 자식은 자기 번호를 돌려받는다.
+inline int superviseProcs(int procs)
+{
+    setSignals(true);
+    std::vector<pid_t> pids(procs,0);
+    using Clock = std::chrono::steady_clock;
+    std::vector<Clock::time_point> started(procs);
+
+    // fork 하고 준비 알림 파이프의 읽기 쪽을 돌려준다 (자식이면 -1 + child=true)
+    auto spawn=[&](int k, bool& child)->int{
+        int fds[2]; if(pipe(fds)<0){ perror("pipe"); return -1; }
+        std::cout.flush(); std::cerr.flush();         // 버퍼가 자식에 복제되지 않게
+        pid_t pid=fork();
+        if(pid==0){ close(fds[0]); ready_fd=fds[1]; child=true; setSignals(false); return -1; }
+        close(fds[1]);
+        if(pid<0){ perror("fork"); close(fds[0]); return -1; }
+        pids[k]=pid; started[k]=Clock::now();
+        std::cout<<"🔵 PROC "<<k<<" : pid "<<pid<<'\n';
+        return fds[0];
+    };
+    auto waitReady=[](int fd){
+        if(fd<0) return;
+        pollfd pf{fd,POLLIN,0}; char b;
+        if(poll(&pf,1,READY_TIMEOUT_MS)>0) (void)!read(fd,&b,1);
+        close(fd);
+    };
+
+    bool child=false;
+    for(int k=0;k<procs;++k){
+        int fd=spawn(k,child); if(child) return k;
+        if(fd>=0) close(fd);                          // 첫 기동은 기다리지 않음
+    }
+    while(true){
+        if(sig_term){
+            for(pid_t p: pids) if(p>0) kill(p,SIGTERM);
+            while(wait(nullptr)>0) {}
+            std::exit(0);
+        }
+        if(sig_dump){
+            sig_dump=0;
+            for(pid_t p: pids) if(p>0) kill(p,SIGUSR1);
+        }
+        if(sig_hup){
+            sig_hup=0;
+            std::cout<<"🟡 rolling restart\n";
+            for(int k=0;k<procs && !sig_term;++k){
+                pid_t old=pids[k];
+                int fd=spawn(k,child); if(child) return k;
+                waitReady(fd);
+                if(old>0){ kill(old,SIGTERM); waitpid(old,nullptr,0); }
+            }
+            continue;
+        }
+        int st; pid_t p=waitpid(-1,&st,0);
+        if(p<=0) continue;                            // 시그널로 깨어남
+        auto it=std::find(pids.begin(),pids.end(),p);
+        if(it==pids.end()) continue;                  // 교체로 이미 대체된 프로세스
+        int k=(int)(it-pids.begin());
+        std::cerr<<"🔴 PROC "<<k<<" (pid "<<p<<") exited, status "<<st<<" → restart\n";
+        if(Clock::now()-started[k] < std::chrono::seconds(1))
+            std::this_thread::sleep_for(std::chrono::seconds(1));   // 기동 직후 죽는 경우 재시작 폭주 방지
+        int fd=spawn(k,child); if(child) return k;
+        if(fd>=0) close(fd);
+    }
+}
@@ -0,0 +1,85 @@
+// result_cache.hpp
+// 동일 프레임(정지 화면, 테스트 패턴, 멈춘 카메라의 반복 JPEG) 결과 캐시.
+// 키 = JPEG 바이트 해시 + 모델 id + 스트림 설정, 값 = 결과 (검출 목록 + 직렬화 문자열).
+// 모델 id 가 키에 들어가므로 모델을 바꾸면 이전 결과는 조회되지 않고 LRU 로 밀려난다.
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+
+#if __has_include(<xxhash.h>)
+#  define XXH_INLINE_ALL
+#  include <xxhash.h>
+#  define RESULT_CACHE_XXH3 1
+#endif
+
+/* ───── 64bit 콘텐츠 해시 ─────────────────────────────────────────────────
+ * xxhash 가 있으면 XXH3, 없으면 8바이트 단위 곱셈-회전 해시로 대체.         */
+inline uint64_t contentHash(const void* data, size_t len, uint64_t seed = 0)
+{
+#ifdef RESULT_CACHE_XXH3
+    return XXH3_64bits_withSeed(data, len, seed);
+#else
+    constexpr uint64_t K1 = 0x9E3779B185EBCA87ull, K2 = 0xC2B2AE3D27D4EB4Full;
+    auto rotl = [](uint64_t x, int r){ return (x << r) | (x >> (64 - r)); };
+    const unsigned char* p = (const unsigned char*)data;
+    uint64_t h = seed ^ (len * K1);
+    for (; len >= 8; p += 8, len -= 8) {
+        uint64_t v; std::memcpy(&v, p, 8);
+        h = rotl(h ^ (v * K2), 31) * K1;
+    }
+    uint64_t tail = 0; std::memcpy(&tail, p, len);
+    h ^= tail * K2;
+    h ^= h >> 33; h *= K2; h ^= h >> 29; h *= K1; h ^= h >> 32;
+    return h;
+#endif
+}
+
+/* ───── 샤드별 잠금 LRU ──────────────────────────────────────────────────
+ * 연결 스레드들이 동시에 조회하므로 키 해시로 샤드를 골라 잠금 경합을 나눈다. */
+template <class V>
+class ResultCache {
+public:
+    explicit ResultCache(size_t capacity) : per_shard_(capacity / SHARDS + 1) {}
+
+    bool get(uint64_t key, V& out) {
+        Shard& s = shard(key);
+        std::lock_guard<std::mutex> lk(s.m);
+        auto it = s.map.find(key);
+        if (it == s.map.end()) { misses_.fetch_add(1, std::memory_order_relaxed); return false; }
+        s.lru.splice(s.lru.begin(), s.lru, it->second);          // 최근 사용으로 이동
+        out = it->second->second;
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    void put(uint64_t key, const V& val) {
+        Shard& s = shard(key);
+        std::lock_guard<std::mutex> lk(s.m);
+        auto it = s.map.find(key);
+        if (it != s.map.end()) { it->second->second = val; s.lru.splice(s.lru.begin(), s.lru, it->second); return; }
+        s.lru.emplace_front(key, val);
+        s.map[key] = s.lru.begin();
+        if (s.map.size() > per_shard_) { s.map.erase(s.lru.back().first); s.lru.pop_back(); }
+    }
+
+    uint64_t hits()   const { return hits_.load(std::memory_order_relaxed); }
+    uint64_t misses() const { return misses_.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t SHARDS = 8;
+    using Entry = std::pair<uint64_t, V>;
+    struct Shard {
+        std::mutex m;
+        std::list<Entry> lru;
+        std::unordered_map<uint64_t, typename std::list<Entry>::iterator> map;
+    };
+    Shard& shard(uint64_t key) { return shards_[(key >> 61) % SHARDS]; }
+
+    size_t per_shard_;
+    Shard  shards_[SHARDS];
+    std::atomic<uint64_t> hits_{0}, misses_{0};
+};
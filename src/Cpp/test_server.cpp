@@ -12,6 +12,8 @@
 #include <onnxruntime_cxx_api.h>
 #include <opencv2/opencv.hpp>
 
+#include "fast_log.hpp"
+
 // 안전 수신: 정확히 len 바이트를 받을 때까지 반복
 bool readN(int fd, void* buf, size_t len) {
     size_t recvd = 0;
@@ -19,7 +21,7 @@ bool readN(int fd, void* buf, size_t len) {
         ssize_t n = recv(fd, (char*)buf + recvd, len - recvd, 0);
         if (n <= 0) return false;
 
-        std::cout << "buf len : " << n << "\n";
+        FLOG_EVERY_N(FLOG_LV_INFO, 64, "buf len : {}", n);   // recv 64번에 1줄
         recvd += n;
     }
     return true;
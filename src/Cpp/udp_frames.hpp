@@ -0,0 +1,233 @@
+// udp_frames.hpp
+// UDP 프레임 전송: JPEG 를 번호 붙은 데이터그램 조각으로 나눠 보내고, 받는 쪽은 풀 버퍼에 다시 맞춘다.
+// 재전송은 없다. 조각이 빠진 프레임은 데드라인이 지나거나 더 새 프레임이 완성되면 버린다
+// (TCP 처럼 세그먼트 하나 때문에 뒤 프레임이 모두 멈추는 일이 없다).
+//   udpf::BufferPool pool;
+//   udpf::Reassembler rx(pool);
+//   udpf::Frame f; if (rx.push(hdr, body, len, now, f)) decode(f.buf->data(), f.len);
+//   rx.expire(now, std::chrono::milliseconds(100));
+//   udpf::LossSim sim; sim.configure("loss=0.05,reorder=0.1,delay=20");   // 루프백 테스트용
+// 데이터그램: [u32 magic][u8 type][u32 stream][u32 frame][u16 idx][u16 cnt][본문] (빅엔디안)
+//   Hello  : 본문 = 핸드셰이크 key=value 텍스트 (서버는 같은 헤더 + "ok ..." 로 응답)
+//   Frag   : 본문 = JPEG 의 idx 번째 조각 (마지막 조각만 PAYLOAD 보다 짧을 수 있음)
+//   Result : 본문 = 결과 한 줄 (서버 → 클라이언트, frame 은 요청 프레임 번호)
+#pragma once
+#include <endian.h>
+#include <netinet/in.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace udpf {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr uint32_t MAGIC     = 0x44525531;        // "DRU1"
+constexpr size_t   HDR       = 17;
+constexpr size_t   PAYLOAD   = 1200;              // 조각 본문 (IPv4/IPv6 경로 MTU 안쪽)
+constexpr size_t   DGRAM_MAX = 65507;             // 결과 데이터그램 상한
+constexpr uint16_t MAX_FRAGS = 2048;              // 프레임당 조각 수 상한 (≈2.4MB)
+constexpr size_t   MAX_OPEN  = 4;                 // 스트림당 동시에 맞추는 프레임 수
+
+enum Type : uint8_t { Hello = 0, Frag = 1, Result = 2 };
+
+struct Hdr { Type type = Frag; uint32_t stream = 0, frame = 0; uint16_t idx = 0, cnt = 1; };
+
+inline void putHdr(uint8_t* p, const Hdr& h) {
+    uint32_t m = htobe32(MAGIC), s = htobe32(h.stream), f = htobe32(h.frame);
+    uint16_t i = htobe16(h.idx), c = htobe16(h.cnt);
+    std::memcpy(p, &m, 4); p[4] = h.type; std::memcpy(p + 5, &s, 4); std::memcpy(p + 9, &f, 4);
+    std::memcpy(p + 13, &i, 2); std::memcpy(p + 15, &c, 2);
+}
+
+inline bool getHdr(const uint8_t* p, size_t n, Hdr& h) {
+    if (n < HDR) return false;
+    uint32_t m, s, f; uint16_t i, c;
+    std::memcpy(&m, p, 4);
+    if (be32toh(m) != MAGIC || p[4] > Result) return false;
+    std::memcpy(&s, p + 5, 4); std::memcpy(&f, p + 9, 4); std::memcpy(&i, p + 13, 2); std::memcpy(&c, p + 15, 2);
+    h = {(Type)p[4], be32toh(s), be32toh(f), be16toh(i), be16toh(c)};
+    return true;
+}
+
+// 프레임 번호는 32비트라 한 바퀴 돌 수 있으므로 차이로 비교
+inline bool newer(uint32_t a, uint32_t b) { return (int32_t)(a - b) > 0; }
+
+/* ───── 프레임 버퍼 풀 ───────────────────────────────────────────────────
+ * 돌려받은 버퍼는 크기를 줄이지 않고 재사용한다 (프레임마다 할당·0 채우기 없음).
+ * 내준 버퍼가 남아 있는 동안 풀은 살아 있어야 한다.                        */
+class BufferPool {
+public:
+    using Buf = std::shared_ptr<std::vector<uint8_t>>;
+    explicit BufferPool(size_t keep = 64) : keep_(keep) {}
+    ~BufferPool() { for (auto* v : free_) delete v; }
+    BufferPool(const BufferPool&) = delete;
+
+    Buf get(size_t n) {
+        std::vector<uint8_t>* v = nullptr;
+        {   std::lock_guard<std::mutex> lk(m_);
+            if (!free_.empty()) { v = free_.back(); free_.pop_back(); }
+        }
+        if (!v) v = new std::vector<uint8_t>();
+        if (v->size() < n) v->resize(n);
+        return Buf(v, [this](std::vector<uint8_t>* b) { put(b); });
+    }
+
+private:
+    void put(std::vector<uint8_t>* v) {
+        {   std::lock_guard<std::mutex> lk(m_);
+            if (free_.size() < keep_) { free_.push_back(v); return; }
+        }
+        delete v;
+    }
+    std::mutex m_;
+    std::vector<std::vector<uint8_t>*> free_;
+    size_t keep_;
+};
+using Buf = BufferPool::Buf;
+
+struct Frame { uint32_t id = 0; Buf buf; size_t len = 0; Clock::time_point first; };
+
+/* ───── 스트림 하나의 조각 맞추기 (스레드 하나에서만 사용) ─────────────────
+ * 프레임이 완성되면 그보다 오래된 미완성 프레임은 모두 버린다 (늦게 와도 쓸모없음).
+ * 완성·포기한 프레임 이하 번호의 조각은 무시한다.                           */
+class Reassembler {
+public:
+    struct Stats { uint64_t complete = 0, incomplete = 0, stale = 0, dup = 0, bad = 0; };
+
+    explicit Reassembler(BufferPool& pool) : pool_(pool) {}
+
+    // 조각 하나. 이 조각으로 프레임이 완성되면 out 에 넣고 true
+    bool push(const Hdr& h, const uint8_t* body, size_t len, Clock::time_point now, Frame& out) {
+        if (h.cnt == 0 || h.cnt > MAX_FRAGS || h.idx >= h.cnt || len == 0 || len > PAYLOAD
+            || (h.idx + 1 < h.cnt && len != PAYLOAD)) { ++stats.bad; return false; }
+        if (any_done_ && !newer(h.frame, done_)) { ++stats.stale; return false; }
+
+        auto it = std::find_if(open_.begin(), open_.end(), [&](const Partial& p) { return p.id == h.frame; });
+        if (it == open_.end()) {
+            if (open_.size() >= MAX_OPEN) abandonFront();      // 가장 먼저 시작한 것
+            Partial p;
+            p.id = h.frame; p.cnt = h.cnt; p.first = now;
+            p.got.assign(h.cnt, 0);
+            p.buf = pool_.get((size_t)h.cnt * PAYLOAD);
+            open_.push_back(std::move(p));
+            it = open_.end() - 1;
+        }
+        Partial& p = *it;
+        if (p.cnt != h.cnt) { ++stats.bad; return false; }
+        if (p.got[h.idx]) { ++stats.dup; return false; }
+        std::memcpy(p.buf->data() + (size_t)h.idx * PAYLOAD, body, len);
+        p.got[h.idx] = 1;
+        if (h.idx + 1 == h.cnt) p.len = (size_t)h.idx * PAYLOAD + len;
+        if (++p.have < p.cnt) return false;
+
+        out = {p.id, std::move(p.buf), p.len, p.first};
+        ++stats.complete;
+        done_ = p.id; any_done_ = true;
+        const size_t before = open_.size();
+        open_.erase(std::remove_if(open_.begin(), open_.end(),
+                                   [&](const Partial& q) { return !newer(q.id, done_); }), open_.end());
+        stats.incomplete += before - open_.size() - 1;   // 완성된 것 하나는 빼고
+        return true;
+    }
+
+    // 첫 조각 뒤 deadline 이 지나도록 못 맞춘 프레임은 버린다
+    void expire(Clock::time_point now, Clock::duration deadline) {
+        while (!open_.empty() && now - open_.front().first > deadline) abandonFront();
+    }
+
+    Stats stats;
+
+private:
+    struct Partial {
+        uint32_t id = 0; uint16_t cnt = 0, have = 0; size_t len = 0;
+        std::vector<uint8_t> got; Buf buf; Clock::time_point first;
+    };
+    // 포기한 프레임의 늦은 조각이 다시 프레임을 열지 않게 done_ 도 올린다
+    void abandonFront() {
+        if (!any_done_ || newer(open_.front().id, done_)) { done_ = open_.front().id; any_done_ = true; }
+        open_.pop_front(); ++stats.incomplete;
+    }
+    BufferPool& pool_;
+    std::deque<Partial> open_;                    // 시작 순서
+    uint32_t done_ = 0; bool any_done_ = false;
+};
+
+/* ───── 손실·순서 뒤바뀜 흉내 (루프백 테스트용) ────────────────────────────
+ * loss=P    : 확률 P 로 버림          reorder=P : 확률 P 로 0~delay ms 늦게 전달
+ * dup=P     : 확률 P 로 한 번 더 전달  delay=MS  : reorder 최대 지연 (기본 20)   seed=N
+ * 받은 데이터그램마다 admit() 이 true 면 바로 처리, 잡아 둔 것은 due() 로 나온다.  */
+class LossSim {
+public:
+    struct Held { std::vector<uint8_t> data; sockaddr_in from; Clock::time_point at; };
+
+    bool configure(const std::string& spec) {
+        std::istringstream is(spec); std::string item;
+        try {
+            while (std::getline(is, item, ',')) {
+                auto eq = item.find('=');
+                if (eq == std::string::npos) return false;
+                const std::string k = item.substr(0, eq); const double v = std::stod(item.substr(eq + 1));
+                if (k == "loss") loss_ = v;
+                else if (k == "reorder") reorder_ = v;
+                else if (k == "dup") dup_ = v;
+                else if (k == "delay") delay_ = std::chrono::milliseconds((int64_t)v);
+                else if (k == "seed") rng_.seed((uint64_t)v);
+                else return false;
+            }
+        } catch (const std::exception&) { return false; }
+        on_ = loss_ > 0 || reorder_ > 0 || dup_ > 0;
+        return loss_ >= 0 && loss_ <= 1 && reorder_ >= 0 && reorder_ <= 1 && dup_ >= 0 && dup_ <= 1;
+    }
+    bool on() const { return on_; }
+
+    bool admit(const uint8_t* p, size_t n, const sockaddr_in& from, Clock::time_point now) {
+        if (!on_) return true;
+        if (coin(loss_)) { ++dropped; return false; }
+        if (coin(dup_)) hold(p, n, from, now);
+        if (coin(reorder_)) {
+            std::uniform_int_distribution<int64_t> d(0, delay_.count());
+            hold(p, n, from, now + std::chrono::milliseconds(d(rng_)));
+            ++reordered; return false;
+        }
+        return true;
+    }
+    // 전달할 때가 된 것 하나
+    bool due(Clock::time_point now, Held& out) {
+        auto it = std::min_element(held_.begin(), held_.end(), [](const Held& a, const Held& b) { return a.at < b.at; });
+        if (it == held_.end() || it->at > now) return false;
+        out = std::move(*it); held_.erase(it);
+        return true;
+    }
+    // 다음 due 까지 남은 시간 (poll 대기 시간용), 없으면 fallback
+    Clock::duration wait(Clock::time_point now, Clock::duration fallback) const {
+        Clock::duration w = fallback;
+        for (const auto& h : held_) w = std::min(w, std::max(Clock::duration::zero(), h.at - now));
+        return w;
+    }
+
+    uint64_t dropped = 0, reordered = 0;
+
+private:
+    bool coin(double p) { return p > 0 && std::uniform_real_distribution<double>(0, 1)(rng_) < p; }
+    void hold(const uint8_t* p, size_t n, const sockaddr_in& from, Clock::time_point at) {
+        held_.push_back({std::vector<uint8_t>(p, p + n), from, at});
+    }
+    bool on_ = false;
+    double loss_ = 0, reorder_ = 0, dup_ = 0;
+    std::chrono::milliseconds delay_{20};
+    std::mt19937_64 rng_{0x5eed};
+    std::vector<Held> held_;
+};
+
+}  // namespace udpf
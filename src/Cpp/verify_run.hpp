@@ -0,0 +1,316 @@
+// verify_run.hpp
+// 골든 출력 회귀 검사 (--verify=DIR): 녹화 프레임을 독립 구현한 기준 경로와 서버 경로에 모두 통과시켜
+// 입력 텐서·출력 점수·검출을 비교한다. ctest 등록은 CMakeLists 의 verify_*.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <onnxruntime_cxx_api.h>
+
+#include "infer_sched.hpp"
+#include "batch_run.hpp"      // expandInputs
+
+/* ───── 골든 출력 회귀 검사 (--verify=DIR) ─────────────────────────────────
+ * 녹화해 둔 프레임(DIR 의 이미지)을 기준 경로와 서버 경로에 모두 통과시켜 비교한다.
+ *   기준 경로 : 픽셀 단위 전처리 → session.Run(일반 텐서) → 모든 클래스 argmax 디코드 → NMS
+ *   서버 경로 : preprocess / preprocessU8 + 스케줄러 → 추론 워커(IoBinding, 배치, huge page …) → postprocess
+ * 확인하는 것 (하나라도 넘으면 종료 코드 1):
+ *   - 입력 텐서: 서버 전처리와 기준 전처리의 최대 차 (1.5/255 이하)
+ *   - 출력 텐서: 골든에 기록한 점수 상위 앵커들의 점수 차 (--verify-tol, 양자화 모델이면 키운다)
+ *   - 검출: 기준↔서버, 골든↔서버 짝이 안 맞는 검출 수 (같은 클래스, IoU ≥ --verify-iou, 점수 차 ≤ tol)
+ *   - 지연: 서버 경로 ÷ 기준 경로 지연 중앙값 (같은 실행, 같은 세션) 이 골든에 기록한 비율보다 --verify-lat
+ *     (기본 20%) 넘게 큼. 기록할 때는 서버 경로가 기준 경로보다 그만큼 느리면 실패. 비율이라 기계가 달라도 쓴다
+ *   - 빈 프레임: 기준 경로 검출이 없는 프레임 (검출 비교가 빈 목록끼리가 되므로 물체가 있는 프레임만 쓴다)
+ * 골든은 --verify-record 로 믿을 수 있는 빌드·모델에서 한 번 기록한다 (기본 DIR/golden.txt). 모델 해시를
+ * 함께 적어 두고, 다른 모델로 돌리면 다시 기록하라고 멈춘다.
+ * --verify-pre 는 모델 없이 입력 텐서(고정·동적 입력 형태, float·uint8)만 비교한다 (기본 ctest). */
+constexpr float VERIFY_TOL    = 0.02f;            // 출력 점수 허용 차
+constexpr float VERIFY_PX_TOL = 1.5f/255.f;       // 입력 텐서 허용 차 (리사이즈 반올림 1단계)
+constexpr float VERIFY_IOU    = 0.9f;
+constexpr float VERIFY_LAT    = 0.2f;             // 지연 비율 허용 증가분
+constexpr int   VERIFY_TOPK   = 32;               // 프레임당 출력 텐서 지문 (점수 상위 앵커 수)
+constexpr int   VERIFY_WARMUP = 3;
+constexpr int   VERIFY_REPS   = 5;                // 프레임당 지연 측정 횟수 (경로마다)
+
+// 기준 전처리: 레터박스 → BGR→RGB → /255 → CHW 를 픽셀 단위로 그대로. u8 모델이면 canvas8 (HWC BGR)
+inline void referencePreprocess(const cv::Mat& src, const cv::Size& in_sz, std::vector<float>& blob,
+                         std::vector<uint8_t>& canvas8, float& scale)
+{
+    const int IW = in_sz.width, IH = in_sz.height;
+    scale = std::min(IW/(float)src.cols, IH/(float)src.rows);
+    const int nw = std::min(IW, int(src.cols*scale)), nh = std::min(IH, int(src.rows*scale));
+    cv::Mat r = src;
+    if (nw != src.cols || nh != src.rows) cv::resize(src, r, {nw, nh});
+    canvas8.assign((size_t)3*IW*IH, 114);
+    for (int y = 0; y < nh; ++y)
+        std::memcpy(canvas8.data() + (size_t)3*y*IW, r.ptr<uint8_t>(y), (size_t)3*nw);
+    blob.resize((size_t)3*IW*IH);
+    for (size_t k = 0; k < (size_t)IW*IH; ++k)
+        for (int c = 0; c < 3; ++c) blob[(size_t)c*IW*IH + k] = canvas8[3*k + 2 - c] / 255.f;
+}
+
+// --verify-pre : 모델 없이 서버 전처리(preprocess, preprocessU8) ↔ 기준 전처리.
+// 고정 입력(640×640)과 동적 입력(긴 변 640·320), 그리고 클라이언트가 맞춰 보낸 크기(fit, 리사이즈 없는 경로)
+inline int runVerifyPre(std::map<std::string,std::string>& opt)
+{
+    std::vector<std::string> files;
+    for (auto& it : expandInputs({opt["verify"]})) if (!it.video) files.push_back(it.path);
+    std::sort(files.begin(), files.end());
+    if (files.empty()) { std::cerr<<"❌ no images in "<<opt["verify"]<<'\n'; return 1; }
+
+    std::vector<float> blob, ref_blob; std::vector<uint8_t> blob8, canvas8;
+    float px_max = 0.f; int cases = 0, bad = 0;
+    for (const auto& path : files) {
+        cv::Mat img = cv::imread(path);
+        if (img.empty()) { std::cerr<<"❌ read failed: "<<path<<'\n'; return 1; }
+        const float fs = std::min(INPUT_W/(float)img.cols, INPUT_H/(float)img.rows);
+        cv::Mat fit; cv::resize(img, fit, {std::min(INPUT_W, int(img.cols*fs)), std::min(INPUT_H, int(img.rows*fs))});
+        for (const cv::Mat* src : {&img, &fit})
+            for (int imgsz : {0, INPUT_W, INPUT_W/2}) {           // 0 = 고정 입력 모델
+                dyn_input = imgsz > 0;
+                const cv::Size in_sz = inputShape(src->size(), imgsz);
+                float s = 1.f, s8 = 1.f, rs = 1.f, px = 0.f;
+                referencePreprocess(*src, in_sz, ref_blob, canvas8, rs);
+                blob.resize((size_t)3*in_sz.area()); blob8.resize(blob.size());
+                preprocess(*src, in_sz, blob.data(), s);
+                preprocessU8(*src, in_sz, blob8.data(), s8);
+                for (size_t i = 0; i < blob.size(); ++i)
+                    px = std::max({px, std::fabs(blob[i] - ref_blob[i]), std::abs(blob8[i] - canvas8[i]) / 255.f});
+                px_max = std::max(px_max, px); ++cases;
+                if (px > VERIFY_PX_TOL || s != rs || s8 != rs) {
+                    ++bad;
+                    std::cout<<"  ✗ "<<path<<' '<<src->cols<<'x'<<src->rows<<" → "<<in_sz.width<<'x'<<in_sz.height
+                             <<" : input Δ"<<px<<" scale "<<s<<'/'<<s8<<" vs "<<rs<<'\n';
+                }
+            }
+    }
+    dyn_input = false;
+    std::cout<<(bad ? "🔴 VERIFY-PRE FAIL" : "🟢 VERIFY-PRE OK")<<" : "<<cases<<" cases ("<<bad<<" differ), input tensor max Δ "
+             <<px_max<<" (≤ "<<VERIFY_PX_TOL<<")\n";
+    return bad ? 1 : 0;
+}
+
+struct RefOut {
+    std::vector<Det>   dets;
+    std::vector<float> anchor;                    // 앵커별 최고 클래스 점수 (원시 출력 모델)
+    float              scale = 1.f;
+    std::vector<float> blob; std::vector<uint8_t> canvas8;
+};
+
+// 기준 경로 한 장. 서버 후처리와 독립된 구현 (점수 컷·면적 필터·NMS 규칙만 같다)
+inline RefOut referenceInfer(Ort::Session& session, const cv::Mat& img)
+{
+    RefOut r;
+    const cv::Size in_sz = inputShape(img.size(), INPUT_W);
+    referencePreprocess(img, in_sz, r.blob, r.canvas8, r.scale);
+    auto mem = Ort::MemoryInfo::CreateCpu(OrtArenaAllocator, OrtMemTypeDefault);
+    Ort::Value in{nullptr};
+    if (u8_input) {
+        int64_t d[4]{1, in_sz.height, in_sz.width, 3};
+        in = Ort::Value::CreateTensor<uint8_t>(mem, r.canvas8.data(), r.canvas8.size(), d, 4);
+    } else {
+        int64_t d[4]{1, 3, in_sz.height, in_sz.width};
+        in = Ort::Value::CreateTensor<float>(mem, r.blob.data(), r.blob.size(), d, 4);
+    }
+    auto outs = session.Run(Ort::RunOptions{}, in_names.data(), &in, 1, out_names.data(), 1);
+    const float* p = outs[0].GetTensorData<float>();
+    auto shp = outs[0].GetTensorTypeAndShapeInfo().GetShape();
+
+    std::vector<cv::Rect> boxes; std::vector<float> scores; std::vector<int> cls;
+    auto keep = [&](float x1, float y1, float w, float h, float s, int c) {
+        if (s < CONF_THR || w*h / in_sz.area() < 0.0005f) return;
+        boxes.emplace_back((int)std::lround(x1/r.scale), (int)std::lround(y1/r.scale),
+                           (int)std::lround(w/r.scale), (int)std::lround(h/r.scale));
+        scores.push_back(s); cls.push_back(c);
+    };
+    if (e2e_rank) {                               // [K,6] / [1,K,6]: 모델 안 NMS 결과 그대로
+        const int64_t K = shp[shp.size() - 2];
+        for (int64_t i = 0; i < K; ++i, p += 6)
+            if (p[5] >= 0 && p[5] < NUM_CLASSES) keep(p[0], p[1], p[2]-p[0], p[3]-p[1], p[4], (int)p[5]);
+        for (size_t i = 0; i < boxes.size(); ++i) r.dets.push_back({boxes[i], cls[i], scores[i]});
+        return r;
+    }
+    const int64_t C = shp[1], N = shp[2];
+    r.anchor.resize(N);
+    for (int64_t i = 0; i < N; ++i) {
+        int best = 0;
+        for (int c = 1; c < C - 4; ++c) if (p[(4 + c)*N + i] > p[(4 + best)*N + i]) best = c;
+        r.anchor[i] = p[(4 + best)*N + i];
+        const float w = p[2*N + i], h = p[3*N + i];
+        keep(p[i] - w/2, p[N + i] - h/2, w, h, r.anchor[i], best);
+    }
+    std::vector<int> idx; cv::dnn::NMSBoxes(boxes, scores, CONF_THR, NMS_THR, idx);
+    for (int i : idx) r.dets.push_back({boxes[i], cls[i], scores[i]});
+    return r;
+}
+
+// a 의 검출 중 b 에 짝(같은 클래스, IoU ≥ iou, 점수 차 ≤ tol)이 없는 수. 짝은 한 번만 쓴다
+inline int unmatched(const std::vector<Det>& a, const std::vector<Det>& b, float iou, float tol)
+{
+    std::vector<bool> used(b.size(), false); int miss = 0;
+    for (const auto& d : a) {
+        int hit = -1;
+        for (size_t k = 0; k < b.size() && hit < 0; ++k) {
+            if (used[k] || b[k].cls != d.cls || std::fabs(b[k].score - d.score) > tol) continue;
+            const float in = (float)(d.box & b[k].box).area(), un = (float)(d.box.area() + b[k].box.area()) - in;
+            if (un > 0 && in/un >= iou) hit = (int)k;
+        }
+        if (hit < 0) ++miss; else used[hit] = true;
+    }
+    return miss;
+}
+
+struct GoldenFrame { std::vector<Det> dets; std::vector<std::pair<int,float>> top; };
+struct Golden { std::map<std::string, GoldenFrame> frames; double latency_ms = 0, latency_ratio = 0; uint64_t model = 0; };
+
+// golden 1 / model <해시> / frame <이름> <검출 수> <지문 수> / d x y w h cls score / t 앵커 점수
+// / latency_ms <서버 경로 중앙값> / latency_ratio <서버 ÷ 기준>
+inline bool loadGolden(const std::string& path, Golden& g)
+{
+    std::ifstream in(path); std::string line, tag;
+    if (!std::getline(in, line) || line != "golden 1") return false;
+    GoldenFrame* cur = nullptr;
+    while (std::getline(in, line)) {
+        std::istringstream is(line); is >> tag;
+        if (tag == "frame") { std::string name; is >> name; cur = &g.frames[name]; }
+        else if (tag == "d" && cur) {
+            Det d; is >> d.box.x >> d.box.y >> d.box.width >> d.box.height >> d.cls >> d.score;
+            cur->dets.push_back(d);
+        } else if (tag == "t" && cur) { std::pair<int,float> t; is >> t.first >> t.second; cur->top.push_back(t); }
+        else if (tag == "latency_ms") is >> g.latency_ms;
+        else if (tag == "latency_ratio") is >> g.latency_ratio;
+        else if (tag == "model") is >> std::hex >> g.model;
+    }
+    return true;
+}
+
+// 서버 경로는 dom 의 스케줄러·워커, 기준 경로는 같은 세션을 직접 Run
+inline int runVerify(Domain& dom, Ort::Session& session, std::map<std::string,std::string>& opt)
+{
+    std::vector<std::string> files;
+    for (auto& it : expandInputs({opt["verify"]})) if (!it.video) files.push_back(it.path);
+    std::sort(files.begin(), files.end());
+    if (files.empty()) { std::cerr<<"❌ no images in "<<opt["verify"]<<'\n'; return 1; }
+    const std::string gpath = opt.count("verify-golden") ? opt["verify-golden"] : opt["verify"]+"/golden.txt";
+    const bool  record = opt.count("verify-record") > 0;
+    const float tol  = opt.count("verify-tol")  ? std::stof(opt["verify-tol"])  : VERIFY_TOL;
+    const float iou  = opt.count("verify-iou")  ? std::stof(opt["verify-iou"])  : VERIFY_IOU;
+    const float lat  = opt.count("verify-lat")  ? std::stof(opt["verify-lat"])  : VERIFY_LAT;   // 음수 = 지연 검사 안 함
+    const int   allow= opt.count("verify-miss") ? std::stoi(opt["verify-miss"]) : 0;    // 허용 불일치 검출 수
+    Golden golden;
+    if (!record && !loadGolden(gpath, golden)) {
+        std::cerr<<"❌ cannot read "<<gpath<<" (먼저 신뢰하는 빌드·모델로 --verify-record)\n"; return 1;
+    }
+    if (!record && golden.model && golden.model != model_id) {
+        std::cerr<<"❌ "<<gpath<<" was recorded with another model (--verify-record 로 다시 기록)\n"; return 1;
+    }
+    std::cout<<"🔵 VERIFY : "<<files.size()<<" frames, "<<(record ? "record → " : "golden ")<<gpath<<'\n';
+
+    const FilterPtr filter = std::make_shared<ClassFilter>();
+    auto serverInfer = [&](const cv::Mat& img, double& ms) {
+        auto job = std::make_shared<Job>();
+        job->tier = 0; job->imgsz = INPUT_W; job->img = img; job->filter = filter;
+        job->deadline = Clock::time_point::max();
+        auto f = job->result.get_future();
+        auto t0 = Clock::now();
+        dom.sched.submit(std::move(job));
+        Result r = f.get();
+        ms = std::chrono::duration<double,std::milli>(Clock::now() - t0).count();
+        return r.dets;
+    };
+
+    std::ofstream gout;
+    if (record) {
+        gout.open(gpath);
+        if (!gout) { perror(gpath.c_str()); return 1; }
+        gout<<"golden 1\nmodel "<<std::hex<<model_id<<std::dec<<'\n';
+    }
+    float px_max = 0.f, t_max = 0.f; int miss_ref = 0, miss_gold = 0, bad_frames = 0, empty = 0;
+    std::vector<double> lats, ref_lats;
+    for (size_t k = 0; k < files.size(); ++k) {
+        cv::Mat img = cv::imread(files[k]);
+        if (img.empty()) { std::cerr<<"❌ read failed: "<<files[k]<<'\n'; return 1; }
+        const std::string name = files[k].substr(files[k].find_last_of('/') + 1);
+
+        double ms = 0;
+        if (k < (size_t)VERIFY_WARMUP) { referenceInfer(session, img); serverInfer(img, ms); }   // 세션 예열 (지연에서 뺌)
+        RefOut ref; std::vector<Det> got;
+        for (int r = 0; r < VERIFY_REPS; ++r) {           // 두 경로를 번갈아 (같은 부하 조건)
+            auto t0 = Clock::now();
+            ref = referenceInfer(session, img);
+            ref_lats.push_back(std::chrono::duration<double,std::milli>(Clock::now() - t0).count());
+            got = serverInfer(img, ms);
+            lats.push_back(ms);
+        }
+        if (ref.dets.empty()) ++empty;
+
+        // 입력 텐서: 서버 전처리 함수를 직접 불러 기준과 비교
+        const cv::Size in_sz = inputShape(img.size(), INPUT_W);
+        float s = 1.f, px = 0.f;
+        if (u8_input) {
+            std::vector<uint8_t> b((size_t)3*in_sz.area());
+            preprocessU8(img, in_sz, b.data(), s);
+            for (size_t i = 0; i < b.size(); ++i) px = std::max(px, std::abs(b[i] - ref.canvas8[i]) / 255.f);
+        } else {
+            std::vector<float> b((size_t)3*in_sz.area());
+            preprocess(img, in_sz, b.data(), s);
+            for (size_t i = 0; i < b.size(); ++i) px = std::max(px, std::fabs(b[i] - ref.blob[i]));
+        }
+        px_max = std::max(px_max, px);
+
+        const int mr = unmatched(ref.dets, got, iou, tol) + unmatched(got, ref.dets, iou, tol);
+        int mg = 0; float td = 0.f;
+        if (record) {
+            std::vector<int> order(ref.anchor.size());
+            std::iota(order.begin(), order.end(), 0);
+            const size_t K = std::min<size_t>(VERIFY_TOPK, order.size());
+            std::partial_sort(order.begin(), order.begin() + K, order.end(),
+                              [&](int a, int b) { return ref.anchor[a] > ref.anchor[b]; });
+            gout<<"frame "<<name<<' '<<ref.dets.size()<<' '<<K<<'\n';
+            for (const auto& d : ref.dets)
+                gout<<"d "<<d.box.x<<' '<<d.box.y<<' '<<d.box.width<<' '<<d.box.height<<' '<<d.cls<<' '<<d.score<<'\n';
+            for (size_t i = 0; i < K; ++i) gout<<"t "<<order[i]<<' '<<ref.anchor[order[i]]<<'\n';
+        } else {
+            auto it = golden.frames.find(name);
+            if (it == golden.frames.end()) { std::cerr<<"❌ "<<name<<" is not in "<<gpath<<'\n'; return 1; }
+            for (const auto& [a, v] : it->second.top)       // 입력 크기가 달라져 앵커 수가 바뀌면 전부 불일치
+                td = std::max(td, a < (int)ref.anchor.size() ? std::fabs(ref.anchor[a] - v) : 1.f);
+            mg = unmatched(it->second.dets, got, iou, tol) + unmatched(got, it->second.dets, iou, tol);
+        }
+        t_max = std::max(t_max, td);
+        miss_ref += mr; miss_gold += mg;
+        if (px > VERIFY_PX_TOL || td > tol || mr > 0 || mg > 0 || ref.dets.empty()) {
+            ++bad_frames;
+            std::cout<<"  ✗ "<<name<<" : input Δ"<<px<<" output Δ"<<td<<" dets ref/server "<<ref.dets.size()<<'/'<<got.size()
+                     <<" unmatched ref "<<mr<<(record ? "" : " golden "+std::to_string(mg))<<'\n';
+        }
+    }
+
+    auto median = [](std::vector<double>& v) { std::sort(v.begin(), v.end()); return v[v.size()/2]; };
+    const double med = median(lats), ref_med = median(ref_lats), ratio = med / ref_med;
+    if (record) { gout<<"latency_ms "<<med<<"\nlatency_ratio "<<ratio<<'\n'; gout.close(); }
+    const double base = !record && golden.latency_ratio > 0 ? golden.latency_ratio : 1.0;   // 기록 때: 기준 경로보다 느리지 않게
+    const bool lat_bad = lat >= 0 && ratio > base * (1 + lat);
+    const bool fail = px_max > VERIFY_PX_TOL || t_max > tol || miss_ref > allow || miss_gold > allow || lat_bad || empty > 0;
+    std::cout<<(fail ? "🔴 VERIFY FAIL" : "🟢 VERIFY OK")<<" : "<<files.size()<<" frames ("<<bad_frames<<" differ)\n"
+             <<"  input tensor  max Δ "<<px_max<<" (≤ "<<VERIFY_PX_TOL<<")\n";
+    if (!record) std::cout<<"  output tensor max Δ "<<t_max<<" (≤ "<<tol<<")\n";
+    std::cout<<"  unmatched dets: ref↔server "<<miss_ref;
+    if (!record) std::cout<<", golden↔server "<<miss_gold;
+    std::cout<<" (≤ "<<allow<<")\n";
+    if (empty) std::cout<<"  frames without reference dets: "<<empty<<" ✗ (물체가 있는 프레임을 쓸 것)\n";
+    std::cout<<"  latency median server "<<med<<"ms / reference "<<ref_med<<"ms = "<<ratio;
+    if (lat >= 0) std::cout<<" (≤ "<<base*(1 + lat)<<(record || golden.latency_ratio <= 0 ? "" : ", golden "+std::to_string(golden.latency_ratio))<<")"<<(lat_bad ? " ✗" : "");
+    if (!record && golden.latency_ms > 0) std::cout<<", golden server "<<golden.latency_ms<<"ms";
+    std::cout<<'\n';
+    return fail ? 1 : 0;
+}
@@ -0,0 +1,94 @@
+# add_nms.py
+# YOLOv8 ONNX 모델 뒤에 디코드(cx,cy,w,h → x1,y1,x2,y2) + NonMaxSuppression 을 붙여서
+# 출력이 [num_dets,6] (x1,y1,x2,y2,score,cls, 입력 캔버스 좌표) 인 모델로 바꾼다.
+# draw_server_async_01 은 출력 끝 축이 6 이면 C++ 디코드·NMS 를 건너뛰고 이 행만 읽는다.
+# C++ 경로와 같은 규칙: 앵커마다 최고 점수 클래스 하나(argmax)만 남기고, NMS 는 클래스 구분 없이
+# (cv::dnn::NMSBoxes 와 같음). 그래서 한 앵커에서 다른 클래스 박스가 겹쳐 나오지 않는다.
+# 다른 점 하나: 스트림 classes= 필터는 argmax 뒤에 적용된다 (C++ 경로는 허용 클래스 안에서 argmax).
+#   python add_nms.py best.onnx best_nms.onnx --score 0.1 --iou 0.45 --max-det 100
+# add_preproc.py 와 순서 상관없이 같이 쓸 수 있다. 출력에 배치 축이 없으므로 배치 1 전용.
+import argparse
+
+import numpy as np
+import onnx
+from onnx import TensorProto, helper, numpy_helper
+
+
+def main():
+    ap = argparse.ArgumentParser(description="ONNX 모델에 NMS 후처리 노드를 붙인다")
+    ap.add_argument('src', help='원본 모델 (출력 [1,4+C,N])')
+    ap.add_argument('dst', help='저장할 모델 (출력 [num_dets,6])')
+    ap.add_argument('--score', type=float, default=0.1,
+                    help='모델 안 점수 컷. 서버 스트림 conf 의 최솟값(cascade 예비 패스는 ×0.5)보다 낮게')
+    ap.add_argument('--iou', type=float, default=0.45)
+    ap.add_argument('--max-det', type=int, default=100, help='최대 검출 수')
+    args = ap.parse_args()
+
+    model = onnx.load(args.src)
+    g = model.graph
+    out = g.output[0]
+    dims = out.type.tensor_type.shape.dim
+    if len(dims) != 3 or dims[1].dim_value <= 4:
+        raise SystemExit(f"❌ 출력이 [1,4+C,N] (C 고정) 가 아닙니다: {out.name}")
+    opset = next(o.version for o in model.opset_import if o.domain in ('', 'ai.onnx'))
+    if opset < 11:
+        raise SystemExit(f"❌ opset {opset} : NonMaxSuppression·GatherND 에 11 이상 필요 (yolo export opset=12)")
+
+    # cx,cy,w,h @ M = x1,y1,x2,y2
+    xyxy = np.array([[1, 0, 1, 0],
+                     [0, 1, 0, 1],
+                     [-.5, 0, .5, 0],
+                     [0, -.5, 0, .5]], dtype=np.float32)
+    g.initializer.extend([
+        numpy_helper.from_array(np.array([0], dtype=np.int64), 'nms_s0'),
+        numpy_helper.from_array(np.array([4], dtype=np.int64), 'nms_s4'),
+        numpy_helper.from_array(np.array([1 << 30], dtype=np.int64), 'nms_end'),
+        numpy_helper.from_array(np.array([2], dtype=np.int64), 'nms_ax2'),
+        numpy_helper.from_array(xyxy, 'nms_xyxy'),
+        numpy_helper.from_array(np.array([args.max_det], dtype=np.int64), 'nms_max'),
+        numpy_helper.from_array(np.array([args.iou], dtype=np.float32), 'nms_iou'),
+        numpy_helper.from_array(np.array([args.score], dtype=np.float32), 'nms_score'),
+        numpy_helper.from_array(np.array(2, dtype=np.int64), 'nms_col_box'),
+        numpy_helper.from_array(np.array([-1, 4], dtype=np.int64), 'nms_rs4'),
+        numpy_helper.from_array(np.array([-1, 1], dtype=np.int64), 'nms_rs1'),
+        numpy_helper.from_array(np.array([-1], dtype=np.int64), 'nms_rsn'),
+        numpy_helper.from_array(np.array([1], dtype=np.int64), 'nms_ax1'),
+    ])
+    # opset 18 부터 ReduceMax 의 axes 는 입력
+    reduce_max = (helper.make_node('ReduceMax', ['nms_scores', 'nms_ax1'], ['nms_best'], keepdims=1) if opset >= 18
+                  else helper.make_node('ReduceMax', ['nms_scores'], ['nms_best'], axes=[1], keepdims=1))
+
+    post = [
+        helper.make_node('Transpose', [out.name], ['nms_t'], perm=[0, 2, 1]),                  # [1,N,4+C]
+        helper.make_node('Slice', ['nms_t', 'nms_s0', 'nms_s4', 'nms_ax2'], ['nms_cxcywh']),   # [1,N,4]
+        helper.make_node('Slice', ['nms_t', 'nms_s4', 'nms_end', 'nms_ax2'], ['nms_cls']),     # [1,N,C]
+        helper.make_node('MatMul', ['nms_cxcywh', 'nms_xyxy'], ['nms_boxes']),                # [1,N,4]
+        helper.make_node('Transpose', ['nms_cls'], ['nms_scores'], perm=[0, 2, 1]),           # [1,C,N]
+        reduce_max,                                                                            # [1,1,N] 앵커별 최고 점수
+        helper.make_node('ArgMax', ['nms_scores'], ['nms_arg'], axis=1, keepdims=0),          # [1,N]   그 클래스
+        helper.make_node('NonMaxSuppression',
+                         ['nms_boxes', 'nms_best', 'nms_max', 'nms_iou', 'nms_score'],
+                         ['nms_sel']),                                                         # [K,3] (b,0,i) 클래스 무관
+        helper.make_node('Gather', ['nms_sel', 'nms_col_box'], ['nms_bi'], axis=1),           # [K]
+        helper.make_node('Reshape', ['nms_boxes', 'nms_rs4'], ['nms_boxes2']),                # [N,4]
+        helper.make_node('Gather', ['nms_boxes2', 'nms_bi'], ['nms_kbox'], axis=0),           # [K,4]
+        helper.make_node('Reshape', ['nms_best', 'nms_rsn'], ['nms_best1']),                  # [N]
+        helper.make_node('Gather', ['nms_best1', 'nms_bi'], ['nms_kscore'], axis=0),          # [K]
+        helper.make_node('Reshape', ['nms_kscore', 'nms_rs1'], ['nms_kscore1']),              # [K,1]
+        helper.make_node('Reshape', ['nms_arg', 'nms_rsn'], ['nms_arg1']),                    # [N]
+        helper.make_node('Gather', ['nms_arg1', 'nms_bi'], ['nms_ci'], axis=0),               # [K]
+        helper.make_node('Cast', ['nms_ci'], ['nms_cif'], to=TensorProto.FLOAT),
+        helper.make_node('Reshape', ['nms_cif', 'nms_rs1'], ['nms_kcls1']),                   # [K,1]
+        helper.make_node('Concat', ['nms_kbox', 'nms_kscore1', 'nms_kcls1'], ['dets'], axis=1),
+    ]
+    g.node.extend(post)
+    del g.output[:]
+    g.output.append(helper.make_tensor_value_info('dets', TensorProto.FLOAT, ['num_dets', 6]))
+
+    onnx.checker.check_model(model)
+    onnx.save(model, args.dst)
+    print(f"✅ {args.dst} : output dets [num_dets,6] (score>={args.score}, iou {args.iou}, class-agnostic)")
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,61 @@
+# add_preproc.py
+# YOLOv8 ONNX 모델 앞에 전처리(Cast → ×1/255 → NHWC→NCHW → BGR→RGB)를 붙여서
+# uint8 [N,H,W,3] BGR 레터박스 캔버스를 그대로 받는 모델로 바꾼다.
+# draw_server_async_01 은 모델 입력이 uint8 이면 자동으로 float 변환 없이 캔버스를 넣는다.
+#   python add_preproc.py best.onnx best_u8.onnx
+import argparse
+
+import numpy as np
+import onnx
+from onnx import TensorProto, helper, numpy_helper
+
+
+def dim_of(d):
+    # 심볼릭 축은 이름, 고정 축은 값, 알 수 없으면 None
+    if d.dim_param:
+        return d.dim_param
+    return d.dim_value if d.dim_value > 0 else None
+
+
+def main():
+    ap = argparse.ArgumentParser(description="ONNX 모델에 uint8 NHWC 전처리 노드를 붙인다")
+    ap.add_argument('src', help='원본 모델 (float [N,3,H,W] RGB 0~1 입력)')
+    ap.add_argument('dst', help='저장할 모델 (uint8 [N,H,W,3] BGR 입력)')
+    args = ap.parse_args()
+
+    model = onnx.load(args.src)
+    g = model.graph
+    inits = {i.name for i in g.initializer}
+    inp = next(i for i in g.input if i.name not in inits)
+    n, c, h, w = [dim_of(d) for d in inp.type.tensor_type.shape.dim]
+    if c != 3 or inp.type.tensor_type.elem_type != TensorProto.FLOAT:
+        raise SystemExit(f"❌ 입력이 float [N,3,H,W] 가 아닙니다: {inp.name}")
+
+    # 원래 입력 이름은 전처리 결과 텐서 이름으로 남겨서 기존 노드는 그대로 둔다
+    new_in = helper.make_tensor_value_info(inp.name + '_u8', TensorProto.UINT8, [n, h, w, 3])
+    pre = [
+        helper.make_node('Cast', [new_in.name], ['pre_f32'], to=TensorProto.FLOAT),
+        helper.make_node('Mul', ['pre_f32', 'pre_scale'], ['pre_norm']),
+        helper.make_node('Transpose', ['pre_norm'], ['pre_nchw'], perm=[0, 3, 1, 2]),
+        helper.make_node('Gather', ['pre_nchw', 'pre_bgr2rgb'], [inp.name], axis=1),
+    ]
+    g.initializer.extend([
+        numpy_helper.from_array(np.array(1.0 / 255.0, dtype=np.float32), 'pre_scale'),
+        numpy_helper.from_array(np.array([2, 1, 0], dtype=np.int64), 'pre_bgr2rgb'),
+    ])
+
+    # repeated 필드는 insert 가 없으므로 다시 채운다
+    others = [i for i in g.input if i.name != inp.name]
+    del g.input[:]
+    g.input.extend([new_in] + others)
+    nodes = list(g.node)
+    del g.node[:]
+    g.node.extend(pre + nodes)
+
+    onnx.checker.check_model(model)
+    onnx.save(model, args.dst)
+    print(f"✅ {args.dst} : input {new_in.name} uint8 [{n},{h},{w},3] BGR")
+
+
+if __name__ == '__main__':
+    main()
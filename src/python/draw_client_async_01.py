@@ -5,7 +5,7 @@ Thread-Pipelined TCP Client (macOS) – display on **main thread**
 """
 from threading import Thread, Event
 from queue     import Queue, Empty, Full
-import cv2, socket, struct, numpy as np, time, sys
+import cv2, socket, struct, numpy as np, time, sys, os
 import re
 import json, pathlib
 
@@ -20,6 +20,17 @@ cfg = json.loads(cfg_path.read_text())
 SERVER_IP    = cfg["client"]["server_ip"]
 SERVER_PORT  = cfg["client"]["server_port"]
 VIDEO_SOURCE = cfg["client"]["video_source"]
+TRANSPORT    = cfg["client"].get("transport", "tcp")   # "udp" : 손실 많은 링크용 (서버 --udp)
+
+# 스트림 설정 (서버 핸드셰이크) – 없으면 핸드셰이크 없이 구버전 방식으로 동작
+STREAM_CFG   = cfg.get("stream", {})           # 예: {"priority": 0, "deadline_ms": 80, "roi": [0, 200, 1280, 520],
+                                               #      "classes": [0, 2], "conf": {"0": 0.5, "2": 0.3},
+                                               #      "enc": "delta", "keyframe": 30}   (결과를 직전 대비 델타로, TCP 만)
+HELLO_MAGIC  = 0x44525731                      # "DRW1"
+UDP_MAGIC    = 0x44525531                      # "DRU1"  [u32 magic][u8 type][u32 stream][u32 frame][u16 idx][u16 cnt]
+UDP_HDR      = struct.Struct(">IBIIHH")
+UDP_PAYLOAD  = 1200                            # 조각 본문 (서버 udp_frames.hpp 와 같아야 함)
+UDP_HELLO, UDP_FRAG, UDP_RESULT = 0, 1, 2
 # ──────────────────────────────────────────────────────
 
 CLASSES = [
@@ -29,50 +40,181 @@ CLASSES = [
     #"big vehicle","vehicle","bike","human","animal","obstacle", # 우리 프로젝트에서 추가한것.
 ]
 
+def now_us():
+    return time.time_ns() // 1000
+
+def hello_text(stream_cfg, extra):
+    def fmt(v):                                   # [0, 2] → "0,2",  {"0": .5} → "0:0.5"
+        if isinstance(v, dict):
+            return ",".join(f"{k}:{x}" for k, x in v.items())
+        if isinstance(v, (list, tuple)):
+            return ",".join(map(str, v))
+        return str(v)
+
+    return " ".join(f"{k}={fmt(v)}" for k, v in {**stream_cfg, **extra}.items()).encode()
+
+def send_hello(sock, stream_cfg, frame_size=None):
+    """priority / deadline_ms 등을 key=value 텍스트로 보내고 서버의 "ok ..." 한 줄을 돌려받는다.
+    ts=1 을 함께 보내서 서버가 받아들이면 프레임 헤더에 촬영·송신 시각을 붙인다 (서버 --trace 용).
+    frame_size=(w,h) 를 보내면 서버가 모델 입력에 맞춘 전송 크기(fit=WxH)를 알려준다."""
+    extra = {"ts": 1}
+    if frame_size:
+        extra["frame"] = f"{frame_size[0]}x{frame_size[1]}"
+    text = hello_text(stream_cfg, extra)
+    sock.sendall(struct.pack(">II", HELLO_MAGIC, len(text)) + text)
+
+    line = b""
+    while not line.endswith(b"\n"):
+        ch = sock.recv(1)
+        if not ch:
+            sys.exit("❌ 서버 핸드셰이크 실패")
+        line += ch
+    print("INFO: 핸드셰이크 –", line.decode().strip())
+    return line.decode()
+
 def capture_frames(cap, frame_q, stop):
     while not stop.is_set():
         ok, frame = cap.read()
         if not ok:
             stop.set(); break
         try:
-            frame_q.put(frame, timeout=.2)
+            frame_q.put((frame, now_us()), timeout=.2)
         except Full:
             pass                                # drop if backlog
 
     cap.release()
 
-def send_and_receive(sock, frame_q, result_q, stop):
+def parse_fit(ack):
+    """ack 의 fit=WxH → (w, h). 없거나 0x0 이면 None (원본 그대로 전송)"""
+    m = re.search(r"\bfit=(\d+)x(\d+)", ack)
+    if not m or m.group(1) == "0":
+        return None
+    return int(m.group(1)), int(m.group(2))
+
+def send_and_receive(sock, frame_q, result_q, stop, send_ts=False, fit=None, delta=None):
     enc_param = [cv2.IMWRITE_JPEG_QUALITY, JPEG_QUALITY]
-    rx_buf = ""                                   # ← 수신 버퍼
+    rx_buf = b""                                  # ← 수신 버퍼
+    server_render = STREAM_CFG.get("render") == "jpeg"   # 서버가 그린 프레임을 돌려받는 모드
+
+    def fill(n):                                  # rx_buf 에 최소 n 바이트가 쌓일 때까지 수신
+        nonlocal rx_buf
+        while len(rx_buf) < n:
+            chunk = sock.recv(65536)
+            if not chunk:
+                raise ConnectionResetError
+            rx_buf += chunk
 
     while not stop.is_set():
         try:
-            frame = frame_q.get(timeout=.2)
+            frame, cap_us = frame_q.get(timeout=.2)
         except Empty:
             continue
 
-        ok, buf = cv2.imencode(".jpg", frame, enc_param)
+        # 서버가 알려준 크기로 줄여서 인코딩 → 전송량·서버 디코드 감소. 결과 좌표는 서버가 원본 기준으로 돌려준다
+        small = cv2.resize(frame, fit, interpolation=cv2.INTER_AREA) if fit and frame.shape[1::-1] != fit else frame
+        ok, buf = cv2.imencode(".jpg", small, enc_param)
         if not ok: continue
         jpeg_bytes = buf.tobytes()
 
         try:
-            sock.sendall(struct.pack(">I", len(jpeg_bytes)))
+            if send_ts:                           # [u32 길이][u64 촬영 μs][u64 송신 μs]
+                sock.sendall(struct.pack(">IQQ", len(jpeg_bytes), cap_us, now_us()))
+            else:
+                sock.sendall(struct.pack(">I", len(jpeg_bytes)))
             sock.sendall(jpeg_bytes)
-            try:
-                resp = sock.recv(4096).decode("utf-8", errors="ignore")
-                if not resp:
-                    stop.set(); break
-                rx_buf += resp
-            except OSError:
-                stop.set(); break
-        except (BrokenPipeError, ConnectionResetError, TimeoutError, OSError):
+
+            if delta:                             # enc=delta: [u32 길이][직전 결과 대비 델타]
+                fill(4)
+                (n,) = struct.unpack(">I", rx_buf[:4])
+                fill(4 + n)
+                bboxes, rx_buf = delta.decode(rx_buf[4:4 + n]), rx_buf[4 + n:]
+            else:
+                # \n 기준으로 완전한 한 줄 수신
+                while b"\n" not in rx_buf:
+                    fill(len(rx_buf) + 1)
+                line, rx_buf = rx_buf.split(b"\n", 1)
+                bboxes = parse_bbox_string(line.decode("utf-8", errors="ignore"))
+
+            # render=jpeg: 결과 줄 뒤에 [u32 길이][서버가 그린 JPEG] 이 따라온다
+            if server_render:
+                fill(4)
+                (n,) = struct.unpack(">I", rx_buf[:4])
+                fill(4 + n)
+                jpg, rx_buf = rx_buf[4:4 + n], rx_buf[4 + n:]
+                if n:
+                    frame = cv2.imdecode(np.frombuffer(jpg, np.uint8), cv2.IMREAD_COLOR)
+                    bboxes = []                   # 이미 그려져 있음
+        except (BrokenPipeError, ConnectionResetError, TimeoutError, OSError, ValueError, IndexError):
+            stop.set(); break
+
+        result_q.put((frame, bboxes))
+
+# ────────────── UDP 전송 (TRANSPORT == "udp") ─────────────
+# JPEG 를 UDP_PAYLOAD 조각으로 나눠 보내고 결과는 데이터그램 하나로 받는다. 재전송 없음:
+# 조각이 빠진 프레임은 서버가 버리므로 결과가 오지 않는다. 보내는 쪽은 결과를 기다리지 않고
+# 캡처 속도로 계속 보내고, 받는 쪽은 프레임 번호로 보낸 프레임을 찾아 그린다.
+def udp_hello(sock, stream_id, stream_cfg, frame_size=None):
+    extra = {"frame": f"{frame_size[0]}x{frame_size[1]}"} if frame_size else {}
+    pkt = UDP_HDR.pack(UDP_MAGIC, UDP_HELLO, stream_id, 0, 0, 1) + hello_text(stream_cfg, extra)
+    sock.settimeout(.5)
+    for _ in range(10):                          # Hello 도 잃어버릴 수 있으므로 응답이 올 때까지 재전송
+        sock.send(pkt)
+        try:
+            while True:
+                d = sock.recv(65536)
+                magic, typ, sid, *_ = UDP_HDR.unpack_from(d)
+                if magic == UDP_MAGIC and typ == UDP_HELLO and sid == stream_id:
+                    sock.settimeout(None)
+                    print("INFO: UDP 핸드셰이크 –", d[UDP_HDR.size:].decode().strip())
+                    return d[UDP_HDR.size:].decode()
+        except (socket.timeout, struct.error):
+            continue
+    sys.exit("❌ 서버 UDP 핸드셰이크 실패 (서버 --udp 확인)")
+
+def udp_send(sock, stream_id, frame_q, sent, stop, fit=None):
+    enc_param = [cv2.IMWRITE_JPEG_QUALITY, JPEG_QUALITY]
+    frame_id = 0
+    while not stop.is_set():
+        try:
+            frame, _ = frame_q.get(timeout=.2)
+        except Empty:
+            continue
+        small = cv2.resize(frame, fit, interpolation=cv2.INTER_AREA) if fit and frame.shape[1::-1] != fit else frame
+        ok, buf = cv2.imencode(".jpg", small, enc_param)
+        if not ok: continue
+        data = buf.tobytes()
+        frame_id += 1
+        sent[frame_id] = frame
+        sent.pop(frame_id - QUEUE_SIZE * 4, None)   # 결과가 안 온 오래된 프레임은 잊는다
+        cnt = (len(data) + UDP_PAYLOAD - 1) // UDP_PAYLOAD
+        try:
+            for i in range(cnt):
+                sock.send(UDP_HDR.pack(UDP_MAGIC, UDP_FRAG, stream_id, frame_id, i, cnt)
+                          + data[i * UDP_PAYLOAD:(i + 1) * UDP_PAYLOAD])
+        except OSError:
             stop.set(); break
 
-        # \n 기준으로 완전한 한 줄씩 처리
-        while "\n" in rx_buf:
-            line, rx_buf = rx_buf.split("\n", 1)
-            bboxes = parse_bbox_string(line)
-            result_q.put((frame, bboxes))
+def udp_receive(sock, stream_id, sent, result_q, stop):
+    sock.settimeout(.2)
+    last = 0
+    while not stop.is_set():
+        try:
+            d = sock.recv(65536)
+            magic, typ, sid, fid, _, _ = UDP_HDR.unpack_from(d)
+        except (socket.timeout, struct.error):
+            continue
+        except OSError:                          # ICMP port unreachable 등
+            continue
+        if magic != UDP_MAGIC or typ != UDP_RESULT or sid != stream_id or fid <= last:
+            continue
+        last = fid                               # 늦게 온 이전 프레임 결과는 버림
+        frame = sent.pop(fid, None)
+        if frame is None:
+            continue
+        try:
+            result_q.put((frame, parse_bbox_string(d[UDP_HDR.size:].decode("utf-8", errors="ignore"))), timeout=.2)
+        except Full:
+            pass
 
 def parse_bbox_string(s: str):
     if not s: return []
@@ -85,6 +227,54 @@ def parse_bbox_string(s: str):
     step = 5 if len(nums) % 5 == 0 else 4
     return [tuple(nums[i:i+step]) for i in range(0, len(nums), step)]
 
+class DeltaDecoder:
+    """enc=delta 결과 (서버 det_delta.hpp). 서버와 같은 박스 목록을 들고 있다가 메시지마다 갱신한다.
+    Key   : [0][n] n×[x][y][w][h][cls]
+    Delta : [1][삭제 수][인덱스 증가분]… [이동 수][인덱스 증가분][dx][dy][dw][dh]… [추가 수][x][y][w][h][cls]…
+    정수는 varint, 좌표·차이는 zigzag. 깨진 메시지면 ValueError."""
+    def __init__(self):
+        self.boxes = None
+
+    def decode(self, msg):
+        pos = 1
+        def uv():
+            nonlocal pos
+            v = shift = 0
+            while True:
+                if pos >= len(msg) or shift > 63:
+                    raise ValueError("delta: truncated")
+                b = msg[pos]; pos += 1
+                v |= (b & 0x7F) << shift; shift += 7
+                if b < 0x80:
+                    return v
+        def zz():
+            v = uv()
+            return (v >> 1) ^ -(v & 1)
+        def box():
+            return (zz(), zz(), zz(), zz(), uv())
+
+        if msg and msg[0] == 0:
+            boxes = [box() for _ in range(uv())]
+        elif msg and msg[0] == 1 and self.boxes is not None:
+            boxes = list(self.boxes)
+            keep = [True] * len(boxes)
+            j = 0
+            for _ in range(uv()):                 # 삭제
+                j += uv(); keep[j] = False
+            j = 0
+            for _ in range(uv()):                 # 이동
+                j += uv()
+                x, y, w, h, c = boxes[j]
+                boxes[j] = (x + zz(), y + zz(), w + zz(), h + zz(), c)
+            boxes = [b for b, k in zip(boxes, keep) if k]
+            boxes += [box() for _ in range(uv())]  # 추가
+        else:
+            raise ValueError("delta: unexpected message")
+        if pos != len(msg):
+            raise ValueError("delta: trailing bytes")
+        self.boxes = boxes
+        return list(boxes)
+
 def display_loop(result_q, stop):
     cv2.namedWindow("Client (q to quit)", cv2.WINDOW_NORMAL)
     t0 = time.time(); fcnt = 0; fps = 0.
@@ -129,17 +319,27 @@ def main():
     if not cap.isOpened():
         sys.exit("❌ 비디오 소스를 열 수 없습니다.")
 
+    frame_q, result_q = Queue(QUEUE_SIZE), Queue(QUEUE_SIZE)
+    stop_event = Event()
+    if TRANSPORT == "udp":
+        return main_udp(cap, frame_q, result_q, stop_event)
+
     sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
     sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
     sock.connect((SERVER_IP, SERVER_PORT))
-
-    frame_q, result_q = Queue(QUEUE_SIZE), Queue(QUEUE_SIZE)
-    stop_event = Event()
+    send_ts, fit, delta = False, None, None
+    if STREAM_CFG:
+        size = (int(cap.get(cv2.CAP_PROP_FRAME_WIDTH)), int(cap.get(cv2.CAP_PROP_FRAME_HEIGHT)))
+        ack = send_hello(sock, STREAM_CFG, size if size[0] > 0 else None)
+        send_ts, fit = " ts=1" in ack, parse_fit(ack)
+        delta = DeltaDecoder() if " enc=delta" in ack else None
+        if fit:
+            print(f"INFO: 전송 크기 {size[0]}x{size[1]} → {fit[0]}x{fit[1]}")
 
     # ── 백그라운드 스레드 두 개만 기동 ──
     threads = [
         Thread(target=capture_frames, args=(cap, frame_q, stop_event), daemon=True),
-        Thread(target=send_and_receive, args=(sock, frame_q, result_q, stop_event), daemon=True),
+        Thread(target=send_and_receive, args=(sock, frame_q, result_q, stop_event, send_ts, fit, delta), daemon=True),
     ]
     for t in threads: t.start()
 
@@ -151,5 +351,26 @@ def main():
     for t in threads: t.join()
     sock.close()
 
+def main_udp(cap, frame_q, result_q, stop_event):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.connect((SERVER_IP, SERVER_PORT))
+    stream_id = int.from_bytes(os.urandom(4), "big")   # 재시작하면 새 스트림
+    size = (int(cap.get(cv2.CAP_PROP_FRAME_WIDTH)), int(cap.get(cv2.CAP_PROP_FRAME_HEIGHT)))
+    fit = parse_fit(udp_hello(sock, stream_id, STREAM_CFG, size if size[0] > 0 else None))
+    if fit:
+        print(f"INFO: 전송 크기 {size[0]}x{size[1]} → {fit[0]}x{fit[1]}")
+
+    sent = {}                                    # 프레임 번호 → 원본 프레임 (결과 대기)
+    threads = [
+        Thread(target=capture_frames, args=(cap, frame_q, stop_event), daemon=True),
+        Thread(target=udp_send, args=(sock, stream_id, frame_q, sent, stop_event, fit), daemon=True),
+        Thread(target=udp_receive, args=(sock, stream_id, sent, result_q, stop_event), daemon=True),
+    ]
+    for t in threads: t.start()
+    display_loop(result_q, stop_event)
+    stop_event.set()
+    for t in threads: t.join()
+    sock.close()
+
 if __name__ == "__main__":
     main()
\ No newline at end of file